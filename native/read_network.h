@@ -0,0 +1,90 @@
+#ifndef __READ_NETWORK_INCLUDED__
+#define __READ_NETWORK_INCLUDED__
+
+#include <fstream>
+#include <map>
+#include <sstream>
+#include "String_Column.h"
+
+// A network read from text files, laid out the same way as the vectors the R
+// functions take. Every string lives in `pool` so equal strings share an address.
+struct Network_Input {
+  String_Pool pool;
+  String_Column nodes_id;
+  String_Column nodes_type;
+  String_Column types_name;
+  std::vector<int> types_count;
+  String_Column edges_from;
+  String_Column edges_to;
+
+  Network_Input() {}
+  Network_Input(const Network_Input& copied) = delete;
+  Network_Input& operator=(const Network_Input& copied) = delete;
+};
+
+// Calls `fn(line_number, fields)` for every line of a whitespace separated file,
+// skipping blank lines and lines starting with #
+template <typename Line_Fn>
+void for_each_line(const std::string& path, const Line_Fn& fn) {
+  std::ifstream file(path);
+  if (!file) stop("Can't open " + path);
+
+  std::string line;
+  for (int line_number = 1; std::getline(file, line); line_number++) {
+    std::istringstream fields(line);
+    std::string first;
+    if (!(fields >> first) || first[0] == '#') continue;
+
+    std::vector<std::string> values{first};
+    for (std::string value; fields >> value;) values.push_back(value);
+    fn(line_number, values);
+  }
+}
+
+// `edges_path` has a from and to id on each line. `nodes_path` (optional) has an id
+// and type on each line; without it every node in the edges has type "node" and nodes
+// come in order of first appearance. Types come in order of first appearance.
+inline void read_network(const std::string& edges_path,
+                         const std::string& nodes_path,
+                         Network_Input& network) {
+  std::map<const char*, int> type_index;
+  auto add_node = [&](const char* id, const char* type) {
+    auto type_it = type_index.find(type);
+    if (type_it == type_index.end()) {
+      type_it = type_index.emplace(type, network.types_name.size()).first;
+      network.types_name.push_back(type);
+      network.types_count.push_back(0);
+    }
+    network.types_count[type_it->second]++;
+    network.nodes_id.push_back(id);
+    network.nodes_type.push_back(type);
+  };
+
+  for_each_line(edges_path, [&](const int line_number, const std::vector<std::string>& fields) {
+    if (fields.size() != 2) {
+      stop(edges_path + " line " + std::to_string(line_number) + ": expected a from and to id");
+    }
+    network.edges_from.push_back(network.pool.intern(fields[0]));
+    network.edges_to.push_back(network.pool.intern(fields[1]));
+  });
+
+  if (!nodes_path.empty()) {
+    for_each_line(nodes_path, [&](const int line_number, const std::vector<std::string>& fields) {
+      if (fields.size() != 2) {
+        stop(nodes_path + " line " + std::to_string(line_number) + ": expected an id and type");
+      }
+      add_node(network.pool.intern(fields[0]), network.pool.intern(fields[1]));
+    });
+    return;
+  }
+
+  const char* type = network.pool.intern("node");
+  std::map<const char*, bool> seen;
+  for (int i = 0; i < network.edges_from.size(); i++) {
+    for (const char* id : {network.edges_from[i], network.edges_to[i]}) {
+      if (seen.emplace(id, true).second) add_node(id, type);
+    }
+  }
+}
+
+#endif
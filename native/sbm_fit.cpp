@@ -0,0 +1,242 @@
+// Command line front end for fitting an SBM without R. Reads a network from
+// text files, fits independent chains and writes the best chain's blocks as
+// tab separated `id`, `type` and `block` columns.
+//
+//   sbm_fit --edges edges.txt --blocks 4 [--nodes nodes.txt] [--out blocks.tsv]
+//
+// Run with --help for the full list of options.
+#include <cstring>
+#include <iostream>
+#include "read_network.h"
+#include "reorder_nodes.h"
+#include "select_num_blocks.h"
+
+struct Fit_Options {
+  std::string edges_path;
+  std::string nodes_path;
+  std::string out_path;
+  int num_blocks = 0;
+  int max_blocks = 0;
+  int candidates_per_round = 4;
+  int num_sweeps = 100;
+  int num_chains = 1;
+  int num_threads = 0;
+  int seed = 42;
+  double eps = 0.1;
+  std::string beta_schedule = "constant";
+  double beta_start = 1.0;
+  double beta_end = 1.0;
+  std::string sweep_order = "fixed";
+  std::string node_order = "input";
+  std::string block_init = "random";
+  std::string convergence_test = "none";
+  int convergence_window = 50;
+  double convergence_tolerance = 1e-3;
+  int eps_tune_sweeps = 0;
+  double eps_target_acceptance = 0.2;
+};
+
+const char* usage =
+    "Usage: sbm_fit --edges FILE --blocks N [options]\n"
+    "\n"
+    "  --edges FILE              Edges, a from and to node id on each line\n"
+    "  --nodes FILE              Nodes, an id and type on each line. Without it\n"
+    "                            every node in the edges has the same type\n"
+    "  --blocks N                Blocks per node type\n"
+    "  --max-blocks N            Search --blocks to N blocks for the smallest\n"
+    "                            description length and write the best fit\n"
+    "  --candidates N            Block counts fitted at once in that search (4)\n"
+    "  --sweeps N                MCMC sweeps per chain (100)\n"
+    "  --chains N                Independent chains, best one is written (1)\n"
+    "  --threads N               Worker threads, 0 for one per core (0)\n"
+    "  --seed N                  Random seed (42)\n"
+    "  --eps X                   Proposal ergodicity parameter (0.1)\n"
+    "  --beta-schedule NAME      constant, linear or geometric (constant)\n"
+    "  --beta-start X            Starting inverse temperature (1)\n"
+    "  --beta-end X              Final inverse temperature (1)\n"
+    "  --sweep-order NAME        fixed, random, degree or active (fixed)\n"
+    "  --node-order NAME         input, degree, bfs or rcm (input)\n"
+    "  --block-init NAME         random, label_propagation or signature (random)\n"
+    "  --convergence-test NAME   none, slope or geweke (none)\n"
+    "  --convergence-window N    Sweeps the convergence test looks at (50)\n"
+    "  --convergence-tol X       Convergence tolerance (0.001)\n"
+    "  --eps-tune-sweeps N       Burn-in sweeps tuning eps per node type (0)\n"
+    "  --eps-target X            Acceptance rate eps is tuned towards (0.2)\n"
+    "  --out FILE                Where to write blocks, stdout if not given\n";
+
+inline int parse_int(const std::string& option, const std::string& value) {
+  std::size_t parsed = 0;
+  int result = 0;
+  try {
+    result = std::stoi(value, &parsed);
+  } catch (const std::exception&) {
+  }
+  if (parsed == 0 || parsed != value.size()) stop(option + " needs a whole number, got " + value);
+  return result;
+}
+
+inline double parse_double(const std::string& option, const std::string& value) {
+  std::size_t parsed = 0;
+  double result = 0;
+  try {
+    result = std::stod(value, &parsed);
+  } catch (const std::exception&) {
+  }
+  if (parsed == 0 || parsed != value.size()) stop(option + " needs a number, got " + value);
+  return result;
+}
+
+inline Fit_Options parse_options(const int argc, const char* const argv[]) {
+  Fit_Options options;
+
+  for (int i = 1; i < argc; i++) {
+    const std::string option = argv[i];
+    if (i + 1 == argc) stop(option + " needs a value");
+    const std::string value = argv[++i];
+
+    if (option == "--edges") options.edges_path = value;
+    else if (option == "--nodes") options.nodes_path = value;
+    else if (option == "--out") options.out_path = value;
+    else if (option == "--blocks") options.num_blocks = parse_int(option, value);
+    else if (option == "--max-blocks") options.max_blocks = parse_int(option, value);
+    else if (option == "--candidates") options.candidates_per_round = parse_int(option, value);
+    else if (option == "--sweeps") options.num_sweeps = parse_int(option, value);
+    else if (option == "--chains") options.num_chains = parse_int(option, value);
+    else if (option == "--threads") options.num_threads = parse_int(option, value);
+    else if (option == "--seed") options.seed = parse_int(option, value);
+    else if (option == "--eps") options.eps = parse_double(option, value);
+    else if (option == "--beta-schedule") options.beta_schedule = value;
+    else if (option == "--beta-start") options.beta_start = parse_double(option, value);
+    else if (option == "--beta-end") options.beta_end = parse_double(option, value);
+    else if (option == "--sweep-order") options.sweep_order = value;
+    else if (option == "--node-order") options.node_order = value;
+    else if (option == "--block-init") options.block_init = value;
+    else if (option == "--convergence-test") options.convergence_test = value;
+    else if (option == "--convergence-window") options.convergence_window = parse_int(option, value);
+    else if (option == "--convergence-tol") options.convergence_tolerance = parse_double(option, value);
+    else if (option == "--eps-tune-sweeps") options.eps_tune_sweeps = parse_int(option, value);
+    else if (option == "--eps-target") options.eps_target_acceptance = parse_double(option, value);
+    else stop("Unknown option " + option);
+  }
+
+  if (options.edges_path.empty()) stop("--edges is required");
+  if (options.num_blocks < 1) stop("--blocks needs to be at least 1");
+  if (options.num_sweeps < 0) stop("--sweeps can't be negative");
+
+  return options;
+}
+
+inline void write_blocks(std::ostream& out,
+                         const Network_Input& network,
+                         const Int_Vec& block_assignments) {
+  out << "id\ttype\tblock\n";
+  for (int i = 0; i < network.nodes_id.size(); i++) {
+    out << network.nodes_id[i] << '\t' << network.nodes_type[i] << '\t'
+        << block_assignments[i] << '\n';
+  }
+}
+
+// Writes to --out, or stdout without it
+inline void write_blocks(const Fit_Options& options,
+                         const Network_Input& network,
+                         const Int_Vec& block_assignments) {
+  if (options.out_path.empty()) {
+    write_blocks(std::cout, network, block_assignments);
+    return;
+  }
+
+  std::ofstream out(options.out_path);
+  if (!out) stop("Can't write to " + options.out_path);
+  write_blocks(out, network, block_assignments);
+}
+
+// Search for the number of blocks, see `select_num_blocks()`
+inline void select_and_write_blocks(const Fit_Options& options,
+                                    const Network_Input& network,
+                                    const Node_Container& nodes,
+                                    const Edge_Container& edges) {
+  const auto selection = select_num_blocks(nodes, edges, options.num_blocks, options.max_blocks,
+                                           options.num_sweeps, options.seed, options.eps,
+                                           options.num_threads, options.candidates_per_round,
+                                           sweep_order_from_name(options.sweep_order),
+                                           block_init_from_name(options.block_init));
+  const Block_Count_Fit& best = selection.fits[selection.best_fit];
+
+  // Number blocks type by type, the same as a chain's assignments
+  Int_Vec block_assignments(nodes.size());
+  for (const auto& nodes_of_type : nodes.nodes) {
+    for (const auto& node : nodes_of_type) {
+      block_assignments[node->index] =
+          node->type_index * best.num_blocks + best.block_positions[node->index];
+    }
+  }
+  write_blocks(options, network, block_assignments);
+
+  std::cerr << "blocks\twarm_start_from\tdescription_length\n";
+  for (const auto& fit : selection.fits) {
+    std::cerr << fit.num_blocks << '\t' << fit.warm_start_from << '\t'
+              << fit.description_length << '\n';
+  }
+  std::cerr << "Best number of blocks: " << best.num_blocks << '\n';
+}
+
+int main(const int argc, const char* const argv[]) {
+  for (int i = 1; i < argc; i++) {
+    if (std::strcmp(argv[i], "--help") == 0 || std::strcmp(argv[i], "-h") == 0) {
+      std::cout << usage;
+      return 0;
+    }
+  }
+
+  try {
+    const Fit_Options options = parse_options(argc, argv);
+
+    Network_Input network;
+    read_network(options.edges_path, options.nodes_path, network);
+
+    auto nodes = Node_Container(network.nodes_id, network.nodes_type,
+                                network.types_name, network.types_count);
+    auto edges = Edge_Container(network.edges_from, network.edges_to, network.nodes_id,
+                                nodes, {}, {}, options.num_threads);
+    reorder_nodes(nodes, node_order_from_name(options.node_order));
+
+    if (options.max_blocks > 0) {
+      select_and_write_blocks(options, network, nodes, edges);
+      return 0;
+    }
+
+    const auto schedule = Beta_Schedule(options.beta_schedule, options.beta_start,
+                                        options.beta_end);
+    const auto convergence = Convergence_Settings(options.convergence_test,
+                                                  options.convergence_window,
+                                                  options.convergence_tolerance);
+    const auto eps_tuning = Eps_Tuning(options.eps_tune_sweeps, options.eps_target_acceptance);
+
+    const auto results = run_chains(nodes, edges, options.num_blocks, options.num_sweeps,
+                                    options.num_chains, options.seed, options.eps,
+                                    options.num_threads, schedule,
+                                    sweep_order_from_name(options.sweep_order),
+                                    block_init_from_name(options.block_init), convergence,
+                                    eps_tuning);
+    const Chain_Results& best = results.chains[results.best_chain];
+
+    write_blocks(options, network, best.block_assignments);
+
+    std::cerr << nodes.size() << " nodes, " << network.edges_from.size() << " edges, "
+              << options.num_chains << " chain(s). Best chain " << results.best_chain + 1
+              << " ran " << best.num_sweeps() << " sweeps to entropy " << best.entropy()
+              << '\n';
+    if (eps_tuning.enabled()) {
+      std::cerr << "Tuned eps:";
+      for (int type_i = 0; type_i < network.types_name.size(); type_i++) {
+        std::cerr << ' ' << network.types_name[type_i] << '=' << best.eps_by_type[type_i];
+      }
+      std::cerr << '\n';
+    }
+  } catch (const std::exception& err) {
+    std::cerr << "sbm_fit: " << err.what() << '\n';
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,426 @@
+#ifndef __BLOCK_EDGE_COUNTS_INCLUDED__
+#define __BLOCK_EDGE_COUNTS_INCLUDED__
+
+#include <algorithm>
+#include <unordered_map>
+#include "Node.h"
+
+// Number of edge ends running between every pair of blocks (e_rs). Entry r, s counts
+// the edges from children of r to children of s, so it is symmetric and the diagonal
+// holds twice the number of edges within a block, the same as
+// `Node::get_block_edge_counts()` on a block.
+//
+// Counts are kept as sparse hash rows while there are lots of blocks (e.g. early in an
+// agglomerative fit where B is close to N) and as a dense matrix once there are few
+// enough blocks per type for that to fit under `max_dense_bytes`. Which one is in use
+// is invisible from the outside. Blocks are addressed by their `index`.
+//
+// The dense matrix only has room for pairs of types that can share edges (see
+// `connect_types()`): a row for a block of type t holds one run of entries for each type
+// t connects to, B_u long for type u. So a bipartite network needs 2 B_a B_b entries
+// rather than (B_a + B_b) squared, and it's this size, worked out from the blocks of
+// each type, that decides when to go dense.
+//
+// Alongside the dense matrix each row keeps a Fenwick tree over each of its runs. That
+// lets `sample_neighbor_block()` pick a block in proportion to e_rs in O(log B) and
+// keeps updates at O(log B) per entry. Sparse rows are walked.
+//
+// Each row also has a version that goes up whenever anything in it changes, which
+// covers the block's degree too, so results worked out from a row can be reused until
+// its version moves on.
+class Block_Edge_Counts {
+ private:
+  using Sparse_Row = std::unordered_map<int, int>;
+
+  bool dense = false;
+  size_t max_dense_bytes = 64 * 1024 * 1024;
+  int num_blocks = 0;
+  int n_types = 0;
+  std::vector<char> types_connect;     // n_types squared, whether two types share edges
+  std::vector<int> blocks_per_type;
+
+  Node_Ptrs block_by_index;            // nullptr for indices without a block
+  std::vector<unsigned> row_versions;  // By block index
+  std::vector<Sparse_Row> sparse_rows; // By block index, only nonzero entries
+
+  std::vector<int> slot_of_block;      // By block index, -1 when absent
+  Node_Ptrs block_of_slot;             // Compact position in dense matrix -> block
+  std::vector<int> first_slot_of_type; // Num types + 1, slots of type t are a run
+  std::vector<int> run_offset;         // n_types squared, start of type u's run in a
+                                       // row of type t, -1 when they don't connect
+  std::vector<size_t> row_start;       // By slot, where its row starts
+  std::vector<int> dense_counts;       // Rows one after another
+  std::vector<int> row_trees;          // Same layout, Fenwick trees over each run
+
+  bool connected(const int type_a, const int type_b) const {
+    return types_connect[type_a * n_types + type_b];
+  }
+
+  int run_start(const int type_r, const int type_s) const {
+    return run_offset[type_r * n_types + type_s];
+  }
+
+  // Where e_rs sits in the dense matrix, -1 when r and s are of types that can't share
+  // edges
+  long dense_position(const Node* r, const Node* s) const {
+    const int start = run_start(r->type_index, s->type_index);
+    if (start < 0) return -1;
+    return row_start[slot_of_block[r->index]] + start +
+           slot_of_block[s->index] - first_slot_of_type[s->type_index];
+  }
+
+  // Fenwick tree over the run of row `slot_r` (of type `type_r`) holding blocks of type
+  // `type`. Positions are 0 based within the run.
+  int* row_tree(const int slot_r, const int type_r, const int type) {
+    return row_trees.data() + row_start[slot_r] + run_start(type_r, type);
+  }
+
+  const int* row_tree(const int slot_r, const int type_r, const int type) const {
+    return row_trees.data() + row_start[slot_r] + run_start(type_r, type);
+  }
+
+  int run_length(const int type) const {
+    return first_slot_of_type[type + 1] - first_slot_of_type[type];
+  }
+
+  static void tree_add(int* tree, const int n, const int pos, const int delta) {
+    for (int i = pos + 1; i <= n; i += i & -i) tree[i - 1] += delta;
+  }
+
+  static int tree_total(const int* tree, const int n) {
+    int total = 0;
+    for (int i = n; i > 0; i -= i & -i) total += tree[i - 1];
+    return total;
+  }
+
+  // Position whose cumulative count first goes past `target`
+  static int tree_search(const int* tree, const int n, int target) {
+    int step = 1;
+    while (step * 2 <= n) step *= 2;
+
+    int pos = 0;
+    for (; step > 0; step /= 2) {
+      if (pos + step <= n && tree[pos + step - 1] <= target) {
+        pos += step;
+        target -= tree[pos - 1];
+      }
+    }
+    return pos;
+  }
+
+  void add_to_entry(const Node* r, const Node* s, const int delta) {
+    row_versions[r->index]++;
+
+    if (dense) {
+      const long position = dense_position(r, s);
+      if (position < 0) stop("Edge between blocks of types that were never connected");
+
+      const int slot_r = slot_of_block[r->index];
+      dense_counts[position] += delta;
+      tree_add(row_tree(slot_r, r->type_index, s->type_index), run_length(s->type_index),
+               slot_of_block[s->index] - first_slot_of_type[s->type_index], delta);
+    } else {
+      Sparse_Row& row = sparse_rows[r->index];
+      const int new_count = (row[s->index] += delta);
+      if (new_count == 0) row.erase(s->index);
+    }
+  }
+
+  // Entries a dense matrix over the current blocks would need
+  size_t dense_size() const {
+    size_t size = 0;
+    for (int type_r = 0; type_r < n_types; type_r++) {
+      size_t row_length = 0;
+      for (int type_s = 0; type_s < n_types; type_s++) {
+        if (connected(type_r, type_s)) row_length += blocks_per_type[type_s];
+      }
+      size += size_t(blocks_per_type[type_r]) * row_length;
+    }
+    return size;
+  }
+
+  // Counts plus their trees
+  bool fits_dense() const { return 2 * dense_size() * sizeof(int) <= max_dense_bytes; }
+
+  void to_dense() {
+    block_of_slot.clear();
+    for (Node* block : block_by_index) {
+      if (block != nullptr) block_of_slot.push_back(block);
+    }
+    std::stable_sort(block_of_slot.begin(), block_of_slot.end(),
+                     [](const Node* a, const Node* b) { return a->type_index < b->type_index; });
+
+    first_slot_of_type.assign(n_types + 1, 0);
+    slot_of_block.assign(block_by_index.size(), -1);
+    for (int slot = 0; slot < block_of_slot.size(); slot++) {
+      slot_of_block[block_of_slot[slot]->index] = slot;
+      first_slot_of_type[block_of_slot[slot]->type_index + 1]++;
+    }
+    for (int type = 0; type < n_types; type++) {
+      first_slot_of_type[type + 1] += first_slot_of_type[type];
+    }
+
+    run_offset.assign(n_types * n_types, -1);
+    std::vector<size_t> row_length(n_types, 0);
+    for (int type_r = 0; type_r < n_types; type_r++) {
+      for (int type_s = 0; type_s < n_types; type_s++) {
+        if (!connected(type_r, type_s)) continue;
+        run_offset[type_r * n_types + type_s] = row_length[type_r];
+        row_length[type_r] += run_length(type_s);
+      }
+    }
+
+    row_start.resize(block_of_slot.size());
+    size_t matrix_size = 0;
+    for (int slot = 0; slot < block_of_slot.size(); slot++) {
+      row_start[slot] = matrix_size;
+      matrix_size += row_length[block_of_slot[slot]->type_index];
+    }
+
+    dense_counts.assign(matrix_size, 0);
+    for (int slot_r = 0; slot_r < block_of_slot.size(); slot_r++) {
+      const Node* r = block_of_slot[slot_r];
+      for (const auto& entry : sparse_rows[r->index]) {
+        const long position = dense_position(r, block_by_index[entry.first]);
+        if (position < 0) stop("Edge between blocks of types that were never connected");
+        dense_counts[position] = entry.second;
+      }
+    }
+
+    // Build each tree in place in linear time, pushing partial sums up to the parent
+    row_trees = dense_counts;
+    for (int slot_r = 0; slot_r < block_of_slot.size(); slot_r++) {
+      const int type_r = block_of_slot[slot_r]->type_index;
+      for (int type = 0; type < n_types; type++) {
+        if (!connected(type_r, type)) continue;
+        int* tree = row_tree(slot_r, type_r, type);
+        const int n = run_length(type);
+        for (int i = 1; i <= n; i++) {
+          const int parent = i + (i & -i);
+          if (parent <= n) tree[parent - 1] += tree[i - 1];
+        }
+      }
+    }
+
+    sparse_rows = std::vector<Sparse_Row>(block_by_index.size());
+    dense = true;
+  }
+
+  void to_sparse() {
+    sparse_rows = std::vector<Sparse_Row>(block_by_index.size());
+    for (const Node* r : block_of_slot) {
+      if (r == nullptr) continue;
+      Sparse_Row& row = sparse_rows[r->index];
+      for_each_dense_in_row(r, [&](const Node* s, const int count) { row[s->index] = count; });
+    }
+
+    dense_counts.clear();
+    dense_counts.shrink_to_fit();
+    row_trees.clear();
+    row_trees.shrink_to_fit();
+    block_of_slot.clear();
+    slot_of_block.clear();
+    first_slot_of_type.clear();
+    run_offset.clear();
+    row_start.clear();
+    dense = false;
+  }
+
+  template <typename Row_Fn>
+  void for_each_dense_in_row(const Node* r, const Row_Fn& fn) const {
+    const int* row = dense_counts.data() + row_start[slot_of_block[r->index]];
+    for (int type_s = 0; type_s < n_types; type_s++) {
+      const int start = run_start(r->type_index, type_s);
+      if (start < 0) continue;
+
+      const int first_slot = first_slot_of_type[type_s];
+      for (int i = 0; i < run_length(type_s); i++) {
+        const int count = row[start + i];
+        if (count != 0) fn(block_of_slot[first_slot + i], count);
+      }
+    }
+  }
+
+ public:
+  // Setters
+  // ===========================================================================
+  // Make room for blocks of `num_types` types, none of which share edges until
+  // connected. Needs calling before any blocks are added.
+  void set_num_types(const int num_types) {
+    if (num_blocks > 0) stop("Types need setting before blocks are added");
+    n_types = num_types;
+    types_connect.assign(n_types * n_types, false);
+    blocks_per_type.assign(n_types, 0);
+  }
+
+  // Let blocks of the two types share edges
+  void connect_types(const int type_a, const int type_b) {
+    if (connected(type_a, type_b)) return;
+    if (dense) to_sparse();
+    types_connect[type_a * n_types + type_b] = true;
+    types_connect[type_b * n_types + type_a] = true;
+    update_representation();
+  }
+
+  // Start tracking a set of blocks. Their counts start empty.
+  void add_blocks(const Node_Ptrs& blocks) {
+    if (dense) to_sparse();
+
+    for (Node* block : blocks) {
+      if (block->type_index >= n_types) stop("Block type hasn't been set up");
+      blocks_per_type[block->type_index]++;
+      if (block->index >= block_by_index.size()) {
+        block_by_index.resize(block->index + 1, nullptr);
+        sparse_rows.resize(block->index + 1);
+        row_versions.resize(block->index + 1, 0);
+      }
+      block_by_index[block->index] = block;
+    }
+    num_blocks += blocks.size();
+
+    update_representation();
+  }
+
+  // Stop tracking an (empty) block. An empty block's row and column are all zeros so
+  // in the dense matrix its slot is simply left unused
+  void remove_block(const Node* block) {
+    if (dense) {
+      block_of_slot[slot_of_block[block->index]] = nullptr;
+      slot_of_block[block->index] = -1;
+    } else {
+      sparse_rows[block->index].clear();
+    }
+    block_by_index[block->index] = nullptr;
+    blocks_per_type[block->type_index]--;
+    num_blocks--;
+
+    update_representation();
+  }
+
+  // Add (`sign` = 1) or remove (`sign` = -1) all of a child node's edges, as if it
+  // belonged to `block`. Each edge end from the child to a node in block t adds to
+  // both r, t and t, r; self edges show up twice in the child's edges so only add to
+  // the diagonal once per appearance.
+  void add_node_edges(const Node* child, const Node* block, const int sign) {
+    for (const auto& edges_of_type : child->get_edges()) {
+      for (const auto& neighbor : edges_of_type) {
+        if (neighbor == child) {
+          add_to_entry(block, block, sign);
+        } else {
+          add_to_entry(block, neighbor->get_parent(), sign);
+          add_to_entry(neighbor->get_parent(), block, sign);
+        }
+      }
+    }
+  }
+
+  // Count a child's edge ends from its block. Doing this for every child of every block
+  // fills in all the counts from scratch (each edge gets seen once from each end)
+  void tally_child_edges(const Node* child) {
+    for (const auto& edges_of_type : child->get_edges()) {
+      for (const auto& neighbor : edges_of_type) {
+        add_to_entry(child->get_parent(), neighbor->get_parent(), 1);
+      }
+    }
+  }
+
+  void move_node(const Node* child, const Node* old_block, const Node* new_block) {
+    add_node_edges(child, old_block, -1);
+    add_node_edges(child, new_block, 1);
+  }
+
+  // Pick representation based on how many blocks there are. Called after every change
+  // in the number of blocks
+  void update_representation() {
+    if (!dense && fits_dense()) to_dense();
+    else if (dense && !fits_dense()) to_sparse();
+  }
+
+  void set_max_dense_bytes(const size_t max_bytes) {
+    max_dense_bytes = max_bytes;
+    update_representation();
+  }
+
+  // Getters
+  // ===========================================================================
+  int get(const Node* r, const Node* s) const {
+    if (dense) {
+      const long position = dense_position(r, s);
+      return position < 0 ? 0 : dense_counts[position];
+    }
+
+    const Sparse_Row& row = sparse_rows[r->index];
+    const auto entry = row.find(s->index);
+    return entry == row.end() ? 0 : entry->second;
+  }
+
+  // Call `fn(Node* s, int e_rs)` for every block s with edges to block r
+  template <typename Row_Fn>
+  void for_each_in_row(const Node* r, const Row_Fn& fn) const {
+    if (dense) {
+      for_each_dense_in_row(r, fn);
+    } else {
+      for (const auto& entry : sparse_rows[r->index]) {
+        fn(block_by_index[entry.first], entry.second);
+      }
+    }
+  }
+
+  // Block of type `type` at the far end of a random edge end from r to that type, so
+  // each block s comes up with probability e_rs over r's degree to the type. Gives
+  // nullptr when r has no edges to the type.
+  Node* sample_neighbor_block(const Node* r, const int type, Random_Engine& random_engine) const {
+    if (dense) {
+      if (type >= n_types || !connected(r->type_index, type)) return nullptr;
+
+      const int* tree = row_tree(slot_of_block[r->index], r->type_index, type);
+      const int n = run_length(type);
+      const int total = tree_total(tree, n);
+      if (total == 0) return nullptr;
+
+      const int edge_end = std::uniform_int_distribution<>{0, total - 1}(random_engine);
+      return block_of_slot[first_slot_of_type[type] + tree_search(tree, n, edge_end)];
+    }
+
+    const Sparse_Row& row = sparse_rows[r->index];
+    int total = 0;
+    for (const auto& entry : row) {
+      if (block_by_index[entry.first]->type_index == type) total += entry.second;
+    }
+    if (total == 0) return nullptr;
+
+    int edge_end = std::uniform_int_distribution<>{0, total - 1}(random_engine);
+    for (const auto& entry : row) {
+      if (block_by_index[entry.first]->type_index != type) continue;
+      edge_end -= entry.second;
+      if (edge_end < 0) return block_by_index[entry.first];
+    }
+    return nullptr;
+  }
+
+  unsigned get_version(const Node* block) const { return row_versions[block->index]; }
+
+  bool is_dense() const { return dense; }
+
+  int size() const { return num_blocks; }
+
+  Memory_Usage memory_usage() const {
+    Memory_Usage usage;
+    usage.add_vector("dense_counts", dense_counts);
+    usage.add_vector("fenwick_trees", row_trees);
+    usage.add_vector("sparse_rows", sparse_rows);
+    for (const auto& row : sparse_rows) add_map(usage, "sparse_rows", row);
+    usage.add_vector("block_lookups", block_by_index);
+    usage.add_vector("block_lookups", slot_of_block);
+    usage.add_vector("block_lookups", block_of_slot);
+    usage.add_vector("block_lookups", first_slot_of_type);
+    usage.add_vector("block_lookups", run_offset);
+    usage.add_vector("block_lookups", row_start);
+    usage.add_vector("block_lookups", types_connect);
+    usage.add_vector("block_lookups", blocks_per_type);
+    usage.add_vector("row_versions", row_versions);
+    return usage;
+  }
+};
+
+#endif
@@ -0,0 +1,144 @@
+#ifndef __CONVERGENCE_MONITOR_INCLUDED__
+#define __CONVERGENCE_MONITOR_INCLUDED__
+
+#include <cmath>
+#include <deque>
+#include "error_helpers.h"
+
+using string = std::string;
+
+// How to decide a chain has stopped drifting, judged on the last `window` sweeps.
+// - none: never stop early.
+// - slope: the least squares trend across the window is within `tolerance` or can't
+//   be told apart from noise (under two standard errors).
+// - geweke: the means of the first 10% and last 50% of the window are within
+//   `tolerance` of each other or differ by under two standard errors.
+// Both the entropy and the acceptance rate need to pass. Entropy tolerance is
+// relative to the size of the entropy, acceptance rate tolerance is absolute.
+enum class Convergence_Test { none, slope, geweke };
+
+enum class Stop_Reason { max_sweeps, converged };
+
+inline Convergence_Test convergence_test_from_name(const string& test_name) {
+  if (test_name == "none") return Convergence_Test::none;
+  if (test_name == "slope") return Convergence_Test::slope;
+  if (test_name == "geweke") return Convergence_Test::geweke;
+  stop("Convergence test must be one of none, slope, or geweke");
+}
+
+inline string stop_reason_name(const Stop_Reason reason) {
+  return reason == Stop_Reason::converged ? "converged" : "max_sweeps";
+}
+
+struct Convergence_Settings {
+  Convergence_Test test = Convergence_Test::none;
+  int window = 50;
+  double tolerance = 1e-3;
+
+  Convergence_Settings() {}
+
+  Convergence_Settings(const Convergence_Test t, const int window_size, const double tol)
+      : test(t), window(window_size), tolerance(tol) {
+    if (test != Convergence_Test::none && window < 10)
+      stop("Convergence window needs to be at least 10 sweeps");
+    if (tolerance < 0) stop("Convergence tolerance can't be negative");
+  }
+
+  Convergence_Settings(const string& test_name, const int window_size, const double tol)
+      : Convergence_Settings(convergence_test_from_name(test_name), window_size, tol) {}
+};
+
+// Watches a chain sweep by sweep and says when it looks stationary
+class Convergence_Monitor {
+ private:
+  Convergence_Settings settings;
+  std::deque<double> entropies;
+  std::deque<double> acceptance_rates;
+  bool converged = false;
+
+  static double mean(const std::deque<double>& values, const int from, const int to) {
+    double total = 0.0;
+    for (int i = from; i < to; i++) total += values[i];
+    return total / (to - from);
+  }
+
+  static double variance(const std::deque<double>& values, const int from, const int to) {
+    const double avg = mean(values, from, to);
+    double total = 0.0;
+    for (int i = from; i < to; i++) total += (values[i] - avg) * (values[i] - avg);
+    return to - from > 1 ? total / (to - from - 1) : 0.0;
+  }
+
+  // Is the trend across the window within tolerance or too small to tell from noise
+  static bool flat_by_slope(const std::deque<double>& values, const double tolerance) {
+    const int n = values.size();
+    const double x_mean = (n - 1) / 2.0;
+    const double y_mean = mean(values, 0, n);
+
+    double sxx = 0.0;
+    double sxy = 0.0;
+    for (int i = 0; i < n; i++) {
+      sxx += (i - x_mean) * (i - x_mean);
+      sxy += (i - x_mean) * (values[i] - y_mean);
+    }
+    const double slope = sxy / sxx;
+
+    double sse = 0.0;
+    for (int i = 0; i < n; i++) {
+      const double residual = values[i] - y_mean - slope * (i - x_mean);
+      sse += residual * residual;
+    }
+    const double slope_se = std::sqrt(sse / (n - 2) / sxx);
+
+    return std::abs(slope) * (n - 1) <= tolerance || std::abs(slope) < 2 * slope_se;
+  }
+
+  static bool flat_by_geweke(const std::deque<double>& values, const double tolerance) {
+    const int n = values.size();
+    const int n_first = std::max(2, n / 10);
+    const int n_last = n / 2;
+
+    const double diff = mean(values, 0, n_first) - mean(values, n - n_last, n);
+    const double diff_se = std::sqrt(variance(values, 0, n_first) / n_first +
+                                     variance(values, n - n_last, n) / n_last);
+
+    return std::abs(diff) <= tolerance || std::abs(diff) < 2 * diff_se;
+  }
+
+  bool flat(const std::deque<double>& values, const double tolerance) const {
+    return settings.test == Convergence_Test::slope ? flat_by_slope(values, tolerance)
+                                                    : flat_by_geweke(values, tolerance);
+  }
+
+ public:
+  explicit Convergence_Monitor(const Convergence_Settings& convergence_settings)
+      : settings(convergence_settings) {}
+
+  // Record a sweep. Returns true once the chain has converged.
+  bool add_sweep(const double entropy, const double acceptance_rate) {
+    if (settings.test == Convergence_Test::none || converged) return converged;
+
+    entropies.push_back(entropy);
+    acceptance_rates.push_back(acceptance_rate);
+    if (entropies.size() > settings.window) {
+      entropies.pop_front();
+      acceptance_rates.pop_front();
+    }
+    if (entropies.size() < settings.window) return false;
+
+    const double entropy_scale = std::max(std::abs(mean(entropies, 0, entropies.size())), 1.0);
+
+    converged = flat(entropies, settings.tolerance * entropy_scale) &&
+                flat(acceptance_rates, settings.tolerance);
+
+    return converged;
+  }
+
+  bool has_converged() const { return converged; }
+
+  Stop_Reason stop_reason() const {
+    return converged ? Stop_Reason::converged : Stop_Reason::max_sweeps;
+  }
+};
+
+#endif
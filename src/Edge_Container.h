@@ -1,13 +1,14 @@
 #ifndef __EDGE_CONTAINER_INCLUDED__
 #define __EDGE_CONTAINER_INCLUDED__
 
-// [[Rcpp::plugins(cpp11)]]
-#include <Rcpp.h>
+#include <atomic>
+#include <cstdint>
+#include <functional>
 #include <vector>
 #include "Node_Container.h"
 #include "Ordered_Pair.h"
+#include "parallel_helpers.h"
 
-using namespace Rcpp;
 using string = std::string;
 using Edge_Type = Ordered_Pair<int>;
 using Edge_Vec = std::vector<Ordered_Pair<Node*>>;
@@ -25,12 +26,18 @@ private:
 public:
   // Setters
   // ===========================================================================
-  Edge_Container(const CharacterVector& edges_from,
-                 const CharacterVector& edges_to,
-                 const CharacterVector& nodes_id,
+  // Built in passes that each split the edges into chunks across `num_threads`
+  // threads: endpoints are resolved and checked, every node's degree to each type is
+  // counted so its edges can be sized exactly, and then the edges are filled in. The
+  // result (including the order of each node's edges and which error gets raised for
+  // bad input) is the same as adding the edges one at a time in input order.
+  Edge_Container(const String_Column& edges_from,
+                 const String_Column& edges_to,
+                 const String_Column& nodes_id,
                  Node_Container& nodes,
-                 const CharacterVector& allowed_types_from = {},
-                 const CharacterVector& allowed_types_to = {}) {
+                 const String_Column& allowed_types_from = {},
+                 const String_Column& allowed_types_to = {},
+                 const int num_threads = 1) {
 
     Ordered_Pair_Set<int> edge_types;
 
@@ -44,62 +51,175 @@ public:
       }
     }
 
-    // We need to quickly go from a node string id to its integer index in
-    // nodes_* vectors
-    auto id_to_node = nodes.get_id_to_node_map(nodes_id);
-
-    auto get_node = [&](const string& node_id, const int edge_index) {
-      const auto node_loc = id_to_node.find(node_id);
-      if (node_loc == id_to_node.end()) {
-        stop("Node " + node_id + " from edges " +
-             string(edges_from[edge_index]) + " - " +
-             string(edges_to[edge_index]) +
-             " was not provided in list of nodes");
-      }
-      return node_loc->second;
+    const int num_edges = edges_from.size();
+    const int n_types = nodes.num_types();
+    const bool multipartite_nodes = nodes.is_multipartite();
+
+    const int chunk_size = 1 << 16;
+    const int num_chunks = (num_edges + chunk_size - 1) / chunk_size;
+    auto for_each_edge_in_chunks = [&](const std::function<void(int, int)>& edge_fn) {
+      run_in_parallel(num_chunks, num_threads, [&](const int chunk_i) {
+        const int end = std::min(num_edges, (chunk_i + 1) * chunk_size);
+        for (int i = chunk_i * chunk_size; i < end; i++) edge_fn(chunk_i, i);
+      });
     };
 
-    const bool multipartite_nodes = nodes.is_multipartite();
+    // We need to quickly go from a node string id to its node. Edge ends are
+    // matched on string addresses so they don't each need copying.
+    auto id_to_node = nodes.get_id_lookup(nodes_id);
+    const String_Column& from_ids = edges_from;
+    const String_Column& to_ids = edges_to;
 
-    for (int i = 0; i < edges_from.size(); i++) {
-      Node* from_node = get_node(string(edges_from[i]), i);
-      Node* to_node = get_node(string(edges_to[i]), i);
+    Node_Ptrs from_nodes(num_edges);
+    Node_Ptrs to_nodes(num_edges);
+    for_each_edge_in_chunks([&](const int, const int i) {
+      Node* const* from_loc = id_to_node.find_by_address(from_ids[i]);
+      Node* const* to_loc = id_to_node.find_by_address(to_ids[i]);
+      from_nodes[i] = from_loc == nullptr ? nullptr : *from_loc;
+      to_nodes[i] = to_loc == nullptr ? nullptr : *to_loc;
+    });
+
+    // Ids that missed on address (byte-identical strings kept separately, e.g. with a
+    // different encoding mark) get matched on contents
+    auto match_on_contents = [&](Node*& node, const char* node_id) {
+      if (node != nullptr) return;
+      Node* const* node_loc = id_to_node.find(node_id);
+      if (node_loc != nullptr) node = *node_loc;
+    };
+    for (int i = 0; i < num_edges; i++) {
+      match_on_contents(from_nodes[i], from_ids[i]);
+      match_on_contents(to_nodes[i], to_ids[i]);
+    }
+
+    // Check every edge. Each chunk notes its first bad edge and the new edge types
+    // it saw, in the order it saw them
+    auto edge_error = [&](const int i) -> string {
+      auto missing_node = [&](const char* node_id) {
+        return "Node " + string(node_id) + " from edges " +
+               string(from_ids[i]) + " - " + string(to_ids[i]) +
+               " was not provided in list of nodes";
+      };
+      if (from_nodes[i] == nullptr) return missing_node(from_ids[i]);
+      if (to_nodes[i] == nullptr) return missing_node(to_ids[i]);
 
       // We only need to check edge types if we have multiple node types
       if (multipartite_nodes) {
-        // Get edge type for this edge
-        const auto edge_type =
-            Edge_Type(from_node->type_index, to_node->type_index);
-
-        const bool not_in_edge_types = edge_types.count(edge_type) == 0;
+        const auto edge_type = Edge_Type(from_nodes[i]->type_index, to_nodes[i]->type_index);
 
         if (edge_type.is_matching()) {
-          stop("Error for edge " + string(edges_from[i]) + " - " +
-               string(edges_to[i]) +
-               ": Can't have an edge between two nodes of the same type in "
-               "multipartite networks");
+          return "Error for edge " + string(from_ids[i]) + " - " +
+                 string(to_ids[i]) +
+                 ": Can't have an edge between two nodes of the same type in "
+                 "multipartite networks";
         }
 
-        // Only need to take action if this is a new edge type
-        if (not_in_edge_types) {
-          if (types_specified) {
-            stop("The edge type from edge " + string(edges_from[i]) + " - " +
-                 string(edges_to[i]) +
-                 " was not specified in allowed edge types");
-          } else {
-            // Make sure that this edge doesn't violate the rules of
-            // multipartite edges of being between nodes of the same type
-            edge_types.insert(edge_type);
-          }
+        if (types_specified && edge_types.count(edge_type) == 0) {
+          return "The edge type from edge " + string(from_ids[i]) + " - " +
+                 string(to_ids[i]) +
+                 " was not specified in allowed edge types";
         }
       }
+      return "";
+    };
+
+    // Bipartite networks without given edge types only need each edge's ends to differ
+    // in type, and the one edge type they can have gets added after the pass
+    const bool bipartite_any_types = n_types == 2 && !types_specified;
 
-      edges.emplace_back(from_node, to_node);
+    Int_Vec first_bad_edge(num_chunks, num_edges);
+    std::vector<std::vector<Edge_Type>> chunk_edge_types(num_chunks);
+    for_each_edge_in_chunks([&](const int chunk_i, const int i) {
+      if (first_bad_edge[chunk_i] < num_edges) return;
+
+      const bool missing_node = from_nodes[i] == nullptr || to_nodes[i] == nullptr;
+      const bool bad_types =
+          !missing_node && multipartite_nodes &&
+          (bipartite_any_types ? from_nodes[i]->type_index == to_nodes[i]->type_index
+                               : edge_error(i) != "");
+      if (missing_node || bad_types) {
+        first_bad_edge[chunk_i] = i;
+        return;
+      }
 
-      // Add edges to nodes as well
-      from_node->add_edge(to_node);
-      to_node->add_edge(from_node);
+      // Make sure that this edge doesn't violate the rules of multipartite edges
+      // of being between nodes of the same type
+      if (multipartite_nodes && !types_specified && !bipartite_any_types) {
+        const auto edge_type = Edge_Type(from_nodes[i]->type_index, to_nodes[i]->type_index);
+        auto& seen = chunk_edge_types[chunk_i];
+        if (std::find(seen.begin(), seen.end(), edge_type) == seen.end()) seen.push_back(edge_type);
+      }
+    });
+
+    const int bad_edge = num_chunks > 0 ? *std::min_element(first_bad_edge.begin(), first_bad_edge.end())
+                                        : num_edges;
+    if (bad_edge < num_edges) stop(edge_error(bad_edge));
+
+    for (const auto& seen : chunk_edge_types) {
+      for (const auto& edge_type : seen) edge_types.insert(edge_type);
     }
+    if (bipartite_any_types && num_edges > 0) edge_types.insert(Edge_Type(0, 1));
+
+    // Count every node's edges to each type, then hand out exactly sized slots
+    Node_Ptrs node_by_index(nodes.size());
+    for (const auto& nodes_of_type : nodes.nodes) {
+      for (const auto& node : nodes_of_type) node_by_index[node->index] = node.get();
+    }
+
+    const int num_slots = nodes.size() * n_types; // Node index x neighbor type
+    std::unique_ptr<std::atomic<int>[]> slot_counts(new std::atomic<int>[num_slots]);
+    for (int slot = 0; slot < num_slots; slot++) slot_counts[slot] = 0;
+
+    auto slot_of = [n_types](const Node* node, const Node* neighbor) {
+      return node->index * n_types + neighbor->type_index;
+    };
+
+    for_each_edge_in_chunks([&](const int, const int i) {
+      slot_counts[slot_of(from_nodes[i], to_nodes[i])].fetch_add(1, std::memory_order_relaxed);
+      slot_counts[slot_of(to_nodes[i], from_nodes[i])].fetch_add(1, std::memory_order_relaxed);
+    });
+
+    std::vector<std::int64_t> slot_starts(num_slots + 1, 0);
+    for (int slot = 0; slot < num_slots; slot++) {
+      slot_starts[slot + 1] = slot_starts[slot] + slot_counts[slot];
+      slot_counts[slot] = 0; // Reused as a fill cursor
+    }
+
+    // Each edge end is keyed by edge index and side so sorting a node's slots puts
+    // them back in input order
+    std::vector<std::uint32_t> end_keys(slot_starts[num_slots]);
+    for_each_edge_in_chunks([&](const int, const int i) {
+      const int from_slot = slot_of(from_nodes[i], to_nodes[i]);
+      const int to_slot = slot_of(to_nodes[i], from_nodes[i]);
+      end_keys[slot_starts[from_slot] + slot_counts[from_slot].fetch_add(1)] = 2u * i;
+      end_keys[slot_starts[to_slot] + slot_counts[to_slot].fetch_add(1)] = 2u * i + 1;
+    });
+
+    const int node_chunk_size = 1024;
+    const int num_node_chunks = (nodes.size() + node_chunk_size - 1) / node_chunk_size;
+    run_in_parallel(num_node_chunks, num_threads, [&](const int chunk_i) {
+      const int end = std::min(nodes.size(), (chunk_i + 1) * node_chunk_size);
+      Node_Ptrs neighbors;
+
+      for (int node_i = chunk_i * node_chunk_size; node_i < end; node_i++) {
+        for (int type_i = 0; type_i < n_types; type_i++) {
+          const int slot = node_i * n_types + type_i;
+          auto keys_begin = end_keys.begin() + slot_starts[slot];
+          auto keys_end = end_keys.begin() + slot_starts[slot + 1];
+          if (keys_begin == keys_end) continue;
+
+          std::sort(keys_begin, keys_end);
+          neighbors.clear();
+          for (auto key = keys_begin; key != keys_end; key++) {
+            const int edge_i = *key / 2;
+            neighbors.push_back(*key % 2 == 0 ? to_nodes[edge_i] : from_nodes[edge_i]);
+          }
+          node_by_index[node_i]->append_edges_to_type(type_i, neighbors);
+        }
+      }
+    });
+
+    edges.reserve(num_edges);
+    for (int i = 0; i < num_edges; i++) edges.emplace_back(from_nodes[i], to_nodes[i]);
 
     // Build map to go from edge type to allowed neighbor types
     if (multipartite_nodes) {
@@ -120,8 +240,21 @@ public:
 
   const Edge_Vec& data() const { return edges; }
 
-  Int_Vec neighbor_types_for_node(const int node_type) const {
-    return neighbor_types.at(node_type);
+  // Empty for types whose nodes have no edges
+  const Int_Vec& neighbor_types_for_node(const int node_type) const {
+    static const Int_Vec no_neighbor_types;
+    const auto types = neighbor_types.find(node_type);
+    return types == neighbor_types.end() ? no_neighbor_types : types->second;
+  }
+
+  // Only what the container keeps. The id lookup and per edge scratch arrays used while
+  // building are gone by the time this can be called.
+  Memory_Usage memory_usage() const {
+    Memory_Usage usage;
+    usage.add_vector("edge_pairs", edges);
+    add_map(usage, "neighbor_types", neighbor_types);
+    for (const auto& types : neighbor_types) usage.add_vector("neighbor_types", types.second);
+    return usage;
   }
 };
 
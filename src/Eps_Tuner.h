@@ -0,0 +1,70 @@
+#ifndef __EPS_TUNER_INCLUDED__
+#define __EPS_TUNER_INCLUDED__
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "error_helpers.h"
+
+using Double_Vec = std::vector<double>;
+using Int_Vec = std::vector<int>;
+
+// Tuning eps separately for each node type over the first `num_sweeps` sweeps (burn-in)
+// so each type accepts close to `target_acceptance` of the proposals that would move it.
+// Off when `num_sweeps` is 0.
+struct Eps_Tuning {
+  int num_sweeps = 0;
+  double target_acceptance = 0.2;
+
+  Eps_Tuning() {}
+
+  Eps_Tuning(const int sweeps, const double target)
+      : num_sweeps(sweeps), target_acceptance(target) {
+    if (num_sweeps < 0) stop("Can't tune eps over a negative number of sweeps");
+    if (target_acceptance <= 0 || target_acceptance >= 1)
+      stop("Target acceptance rate needs to be between 0 and 1");
+  }
+
+  bool enabled() const { return num_sweeps > 0; }
+};
+
+// Stochastic approximation on log eps. A type accepting more than the target gets a
+// larger eps (more proposals to random blocks, which are accepted less), one accepting
+// less gets a smaller eps (proposals follow its neighbors' blocks more closely). Steps
+// shrink as sweeps go by and eps is frozen once burn-in ends, so the sweeps after that
+// use a fixed proposal and keep detailed balance.
+class Eps_Tuner {
+ private:
+  Eps_Tuning settings;
+  Double_Vec eps_by_type;
+  int num_updates = 0;
+
+ public:
+  Eps_Tuner(const int num_types, const double eps, const Eps_Tuning& tuning = Eps_Tuning())
+      : settings(tuning), eps_by_type(num_types, eps) {
+    if (settings.enabled() && eps <= 0) stop("eps needs to be positive to be tuned");
+  }
+
+  // Record a sweep's proposals (that would have moved a node) and accepted moves, both
+  // by node type. Does nothing once frozen. Types without proposals keep their eps.
+  void update(const Int_Vec& proposed_by_type, const Int_Vec& moved_by_type) {
+    if (is_frozen()) return;
+
+    const double gain = 1.0 / std::pow(num_updates + 1.0, 0.6);
+    for (int type_i = 0; type_i < eps_by_type.size(); type_i++) {
+      if (proposed_by_type[type_i] == 0) continue;
+
+      const double acceptance = double(moved_by_type[type_i]) / proposed_by_type[type_i];
+      const double step = (acceptance - settings.target_acceptance) / settings.target_acceptance;
+      const double new_eps = eps_by_type[type_i] * std::exp(gain * std::max(-1.0, std::min(1.0, step)));
+      eps_by_type[type_i] = std::max(1e-3, std::min(1e3, new_eps));
+    }
+    num_updates++;
+  }
+
+  bool is_frozen() const { return num_updates >= settings.num_sweeps; }
+
+  const Double_Vec& get_eps() const { return eps_by_type; }
+};
+
+#endif
@@ -0,0 +1,242 @@
+#ifndef __MAPPED_ADJACENCY_INCLUDED__
+#define __MAPPED_ADJACENCY_INCLUDED__
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "Mapped_File.h"
+#include "String_Lookup.h"
+
+using string = std::string;
+
+// On-disk adjacency for networks too big to hold as `Node`s. Written once by
+// `write_adjacency_file()` and then memory mapped read-only, so the operating system
+// pages edges in and out as sweeps walk through them.
+//
+// Nodes are laid out grouped by type, in input order within a type, and are referred
+// to by that position. Layout (all little endian as written by the host):
+//   Adjacency_Header
+//   int32 node_index[num_nodes]      position -> index in the original `nodes_id`
+//   int32 node_type[num_nodes]       position -> type index
+//   int64 type_edges[num_types^2]    edge ends from each type to each other type
+//   int64 offsets[num_nodes + 1]     start of each node's neighbors
+//   int32 neighbors[num_edge_ends]   neighbor positions, sorted within each node
+// with the int64 sections padded to start on 8 byte boundaries.
+struct Adjacency_Header {
+  char magic[8];
+  std::int64_t num_nodes;
+  std::int64_t num_types;
+  std::int64_t num_edge_ends;
+};
+
+static const char adjacency_magic[8] = {'S', 'B', 'M', 'A', 'D', 'J', '0', '1'};
+
+// Byte offsets of each section for a given set of sizes
+struct Adjacency_Layout {
+  std::size_t node_index, node_type, type_edges, offsets, neighbors, total;
+
+  static std::size_t pad_to_8(const std::size_t bytes) { return (bytes + 7) / 8 * 8; }
+
+  Adjacency_Layout(const std::int64_t num_nodes,
+                   const std::int64_t num_types,
+                   const std::int64_t num_edge_ends) {
+    node_index = sizeof(Adjacency_Header);
+    node_type = node_index + num_nodes * sizeof(std::int32_t);
+    type_edges = pad_to_8(node_type + num_nodes * sizeof(std::int32_t));
+    offsets = type_edges + num_types * num_types * sizeof(std::int64_t);
+    neighbors = offsets + (num_nodes + 1) * sizeof(std::int64_t);
+    total = neighbors + num_edge_ends * sizeof(std::int32_t);
+  }
+};
+
+// Builds the adjacency straight from the string columns (no `Node`s), in two passes over
+// the edges: one to count degrees and one to fill neighbors. Only the flat arrays
+// being written are held in memory.
+inline void write_adjacency_file(const string& path,
+                                 const String_Column& nodes_id,
+                                 const String_Column& nodes_type,
+                                 const String_Column& types_name,
+                                 const String_Column& edges_from,
+                                 const String_Column& edges_to) {
+  const std::int64_t num_nodes = nodes_id.size();
+  const std::int64_t num_types = types_name.size();
+
+  String_Lookup<int> type_lookup(num_types);
+  for (int i = 0; i < num_types; i++) type_lookup.insert(types_name[i], i);
+
+  // Positions: grouped by type, input order within type
+  std::vector<std::int32_t> type_of_index(num_nodes);
+  std::vector<std::int64_t> type_starts(num_types + 1, 0);
+  for (int i = 0; i < num_nodes; i++) {
+    const int* type_i = type_lookup.find(nodes_type[i]);
+    if (type_i == nullptr) {
+      stop("Node " + string(nodes_id[i]) + " has type (" + string(nodes_type[i]) +
+           ") not found in provided node types");
+    }
+    type_of_index[i] = *type_i;
+    type_starts[*type_i + 1]++;
+  }
+  for (int t = 0; t < num_types; t++) type_starts[t + 1] += type_starts[t];
+
+  std::vector<std::int32_t> node_index(num_nodes);
+  std::vector<std::int32_t> node_type(num_nodes);
+  std::vector<std::int32_t> position_of_index(num_nodes);
+  {
+    std::vector<std::int64_t> next_slot(type_starts.begin(), type_starts.end() - 1);
+    for (int i = 0; i < num_nodes; i++) {
+      const std::int64_t pos = next_slot[type_of_index[i]]++;
+      node_index[pos] = i;
+      node_type[pos] = type_of_index[i];
+      position_of_index[i] = pos;
+    }
+  }
+
+  String_Lookup<int> id_lookup(num_nodes);
+  for (int i = 0; i < num_nodes; i++) id_lookup.insert(nodes_id[i], i);
+
+  const std::int64_t num_edges = edges_from.size();
+  std::vector<std::int32_t> edge_from(num_edges);
+  std::vector<std::int32_t> edge_to(num_edges);
+  std::vector<std::int64_t> type_edges(num_types * num_types, 0);
+  std::vector<std::int64_t> offsets(num_nodes + 1, 0);
+
+  for (std::int64_t e = 0; e < num_edges; e++) {
+    const int* from = id_lookup.find(edges_from[e]);
+    const int* to = id_lookup.find(edges_to[e]);
+    if (from == nullptr || to == nullptr) {
+      stop("Node " + string(from == nullptr ? edges_from[e] : edges_to[e]) +
+           " from edges " + string(edges_from[e]) + " - " + string(edges_to[e]) +
+           " was not provided in list of nodes");
+    }
+
+    const int from_type = type_of_index[*from];
+    const int to_type = type_of_index[*to];
+    if (num_types > 1 && from_type == to_type) {
+      stop("Error for edge " + string(edges_from[e]) + " - " + string(edges_to[e]) +
+           ": Can't have an edge between two nodes of the same type in "
+           "multipartite networks");
+    }
+
+    edge_from[e] = position_of_index[*from];
+    edge_to[e] = position_of_index[*to];
+    offsets[edge_from[e] + 1]++;
+    offsets[edge_to[e] + 1]++;
+    type_edges[from_type * num_types + to_type]++;
+    type_edges[to_type * num_types + from_type]++;
+  }
+  for (std::int64_t pos = 0; pos < num_nodes; pos++) offsets[pos + 1] += offsets[pos];
+
+  const std::int64_t num_edge_ends = offsets[num_nodes];
+  std::vector<std::int32_t> neighbors(num_edge_ends);
+  {
+    std::vector<std::int64_t> cursor(offsets.begin(), offsets.end() - 1);
+    for (std::int64_t e = 0; e < num_edges; e++) {
+      neighbors[cursor[edge_from[e]]++] = edge_to[e];
+      neighbors[cursor[edge_to[e]]++] = edge_from[e];
+    }
+  }
+  for (std::int64_t pos = 0; pos < num_nodes; pos++) {
+    std::sort(neighbors.begin() + offsets[pos], neighbors.begin() + offsets[pos + 1]);
+  }
+
+  const Adjacency_Layout layout(num_nodes, num_types, num_edge_ends);
+  Adjacency_Header header;
+  std::memcpy(header.magic, adjacency_magic, sizeof(adjacency_magic));
+  header.num_nodes = num_nodes;
+  header.num_types = num_types;
+  header.num_edge_ends = num_edge_ends;
+
+  std::FILE* file = std::fopen(path.c_str(), "wb");
+  if (file == nullptr) stop("Couldn't open " + path + " for writing");
+
+  std::size_t written_to = 0;
+  bool write_ok = true;
+  auto write_at = [&](const std::size_t offset, const void* data, const std::size_t bytes) {
+    static const char padding[8] = {0};
+    if (offset > written_to) write_ok = write_ok && std::fwrite(padding, 1, offset - written_to, file) == offset - written_to;
+    write_ok = write_ok && std::fwrite(data, 1, bytes, file) == bytes;
+    written_to = offset + bytes;
+  };
+
+  write_at(0, &header, sizeof(header));
+  write_at(layout.node_index, node_index.data(), num_nodes * sizeof(std::int32_t));
+  write_at(layout.node_type, node_type.data(), num_nodes * sizeof(std::int32_t));
+  write_at(layout.type_edges, type_edges.data(), type_edges.size() * sizeof(std::int64_t));
+  write_at(layout.offsets, offsets.data(), offsets.size() * sizeof(std::int64_t));
+  write_at(layout.neighbors, neighbors.data(), num_edge_ends * sizeof(std::int32_t));
+
+  const bool close_ok = std::fclose(file) == 0;
+  if (!write_ok || !close_ok) stop("Failed writing adjacency to " + path);
+}
+
+// Read-only view of an adjacency file. The mapping is released on destruction.
+class Mapped_Adjacency {
+ private:
+  Mapped_File file;
+
+  Adjacency_Header header;
+  const std::int32_t* node_indices;
+  const std::int32_t* node_types;
+  const std::int64_t* type_edge_counts;
+  const std::int64_t* offsets;
+  const std::int32_t* neighbor_positions;
+
+ public:
+  // A file that turns out not to be an adjacency file is let go of before the error
+  // gets raised, along with the rest of the object
+  explicit Mapped_Adjacency(const string& path) : file(path) {
+    if (file.size() < sizeof(Adjacency_Header)) {
+      stop(path + " is too small to be an adjacency file");
+    }
+    std::memcpy(&header, file.data(), sizeof(header));
+
+    const Adjacency_Layout layout(header.num_nodes, header.num_types, header.num_edge_ends);
+    if (std::memcmp(header.magic, adjacency_magic, sizeof(adjacency_magic)) != 0 ||
+        layout.total != file.size()) {
+      stop(path + " isn't an adjacency file written by write_adjacency_file()");
+    }
+
+    const char* data = file.data();
+    node_indices = reinterpret_cast<const std::int32_t*>(data + layout.node_index);
+    node_types = reinterpret_cast<const std::int32_t*>(data + layout.node_type);
+    type_edge_counts = reinterpret_cast<const std::int64_t*>(data + layout.type_edges);
+    offsets = reinterpret_cast<const std::int64_t*>(data + layout.offsets);
+    neighbor_positions = reinterpret_cast<const std::int32_t*>(data + layout.neighbors);
+  }
+
+  Mapped_Adjacency(const Mapped_Adjacency& copied) = delete;
+  Mapped_Adjacency& operator=(const Mapped_Adjacency& copied) = delete;
+
+  // Getters
+  // ===========================================================================
+  int num_nodes() const { return header.num_nodes; }
+
+  int num_types() const { return header.num_types; }
+
+  std::int64_t num_edge_ends() const { return header.num_edge_ends; }
+
+  // Position in the original `nodes_id` of the node at `pos`
+  int node_index(const int pos) const { return node_indices[pos]; }
+
+  int node_type(const int pos) const { return node_types[pos]; }
+
+  int degree(const int pos) const { return offsets[pos + 1] - offsets[pos]; }
+
+  // Edge ends between nodes of two types
+  std::int64_t type_edges(const int type_a, const int type_b) const {
+    return type_edge_counts[type_a * header.num_types + type_b];
+  }
+
+  const std::int32_t* neighbors_begin(const int pos) const {
+    return neighbor_positions + offsets[pos];
+  }
+
+  const std::int32_t* neighbors_end(const int pos) const {
+    return neighbor_positions + offsets[pos + 1];
+  }
+};
+
+#endif
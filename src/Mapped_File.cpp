@@ -0,0 +1,80 @@
+#include "Mapped_File.h"
+#include "error_helpers.h"
+
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+Mapped_File::Mapped_File(const std::string& path) {
+  HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+                            OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+  if (file == INVALID_HANDLE_VALUE) stop("Couldn't open " + path);
+  file_handle = file;
+
+  LARGE_INTEGER file_size;
+  if (!GetFileSizeEx(file, &file_size)) {
+    release();
+    stop("Couldn't get the size of " + path);
+  }
+  num_bytes = file_size.QuadPart;
+
+  mapping_handle = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+  if (mapping_handle == NULL) {
+    release();
+    stop("Couldn't map " + path);
+  }
+
+  data_ptr = static_cast<const char*>(MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0));
+  if (data_ptr == nullptr) {
+    release();
+    stop("Couldn't map " + path);
+  }
+}
+
+void Mapped_File::release() {
+  if (data_ptr != nullptr) UnmapViewOfFile(data_ptr);
+  if (mapping_handle != nullptr) CloseHandle(mapping_handle);
+  if (file_handle != nullptr) CloseHandle(file_handle);
+  data_ptr = nullptr;
+  mapping_handle = nullptr;
+  file_handle = nullptr;
+}
+
+#else
+
+Mapped_File::Mapped_File(const std::string& path) {
+  const int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) stop("Couldn't open " + path);
+
+  struct stat file_info;
+  if (fstat(fd, &file_info) != 0) {
+    close(fd);
+    stop("Couldn't get the size of " + path);
+  }
+  num_bytes = file_info.st_size;
+
+  void* mapped = num_bytes > 0 ? mmap(nullptr, num_bytes, PROT_READ, MAP_SHARED, fd, 0)
+                               : MAP_FAILED;
+  close(fd);
+  if (mapped == MAP_FAILED) stop("Couldn't map " + path);
+
+  // Sweeps walk the file front to back so read ahead aggressively
+  madvise(mapped, num_bytes, MADV_SEQUENTIAL);
+  data_ptr = static_cast<const char*>(mapped);
+}
+
+void Mapped_File::release() {
+  if (data_ptr != nullptr) munmap(const_cast<char*>(data_ptr), num_bytes);
+  data_ptr = nullptr;
+}
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef __MAPPED_FILE_INCLUDED__
+#define __MAPPED_FILE_INCLUDED__
+
+#include <cstddef>
+#include <string>
+
+// Read-only memory map of a whole file, released on destruction. The platform code
+// lives in Mapped_File.cpp so no header pulls in the system headers behind it (on
+// Windows, <windows.h> and its min/max macros).
+class Mapped_File {
+ private:
+  const char* data_ptr = nullptr;
+  std::size_t num_bytes = 0;
+  void* file_handle = nullptr;    // Windows only, the open file and its mapping
+  void* mapping_handle = nullptr;
+
+  void release();
+
+ public:
+  // Raises an error if the file can't be opened or mapped, having let go of anything it
+  // got hold of along the way
+  explicit Mapped_File(const std::string& path);
+
+  Mapped_File(const Mapped_File& copied) = delete;
+  Mapped_File& operator=(const Mapped_File& copied) = delete;
+
+  ~Mapped_File() { release(); }
+
+  const char* data() const { return data_ptr; }
+
+  std::size_t size() const { return num_bytes; }
+};
+
+#endif
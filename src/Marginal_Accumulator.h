@@ -0,0 +1,187 @@
+#ifndef __MARGINAL_ACCUMULATOR_INCLUDED__
+#define __MARGINAL_ACCUMULATOR_INCLUDED__
+
+#include <cstdint>
+#include <unordered_map>
+#include "Edge_Container.h"
+
+using Double_Vec = std::vector<double>;
+
+// Tallies how often each node sits in each block, and how often pairs from a chosen
+// subset of nodes share a block, over the sweeps it is shown. Rather than touching
+// every node every sweep it remembers the sweep each node (and each subset pair that
+// shares a block) last changed at, and only settles up when a node moves or when the
+// totals are read, so a sweep costs time in proportion to the nodes that moved.
+class Marginal_Accumulator {
+ private:
+  int num_samples = 0;
+
+  Int_Vec current_block;    // Block index for each node index
+  Int_Vec block_since;      // Sample number node joined its current block at
+  std::vector<std::unordered_map<int, int>> block_counts; // Settled samples per block
+
+  Node_Ptrs subset;         // Nodes whose pairs are tracked
+  Int_Vec subset_pos;       // Position in subset by node index, -1 when not in it
+  Int_Vec subset_block;     // Block each subset node was in at the last sweep
+  std::unordered_map<std::uint64_t, int> together_since;  // Open pairs sharing a block
+  std::unordered_map<std::uint64_t, int> together_counts; // Settled samples together
+
+  std::uint64_t pair_key(int pos_a, int pos_b) const {
+    if (pos_a > pos_b) std::swap(pos_a, pos_b);
+    return std::uint64_t(pos_a) * subset.size() + pos_b;
+  }
+
+  void settle_node(const int node_i, const int new_block) {
+    block_counts[node_i][current_block[node_i]] += num_samples - block_since[node_i];
+    current_block[node_i] = new_block;
+    block_since[node_i] = num_samples;
+  }
+
+ public:
+  // `subset_indices` are node indices of the nodes to track pairs for
+  Marginal_Accumulator(const Node_Container& nodes, const Int_Vec& subset_indices = {})
+      : current_block(nodes.size()),
+        block_since(nodes.size(), 0),
+        block_counts(nodes.size()),
+        subset_pos(nodes.size(), -1) {
+
+    Node_Ptrs node_by_index(nodes.size());
+    for (const auto& nodes_of_type : nodes.nodes) {
+      for (const auto& node : nodes_of_type) {
+        node_by_index[node->index] = node.get();
+        current_block[node->index] = node->get_parent()->index;
+      }
+    }
+
+    for (const int node_i : subset_indices) {
+      if (node_i < 0 || node_i >= nodes.size()) stop("Node subset index out of range");
+      if (subset_pos[node_i] != -1) continue;
+
+      subset_pos[node_i] = subset.size();
+      subset.push_back(node_by_index[node_i]);
+      subset_block.push_back(current_block[node_i]);
+    }
+
+    // Pairs that start out together
+    for (int a = 0; a < subset.size(); a++) {
+      for (int b = a + 1; b < subset.size(); b++) {
+        if (subset_block[a] == subset_block[b]) together_since[pair_key(a, b)] = 0;
+      }
+    }
+  }
+
+  // Call after every sweep with the nodes that moved during it. The state after the
+  // sweep counts as one sample.
+  void record_sweep(const Node_Ptrs& moved_nodes) {
+    std::vector<int> moved_subset;
+
+    for (const Node* node : moved_nodes) {
+      const int new_block = node->get_parent()->index;
+      if (new_block == current_block[node->index]) continue; // Moved back again
+
+      settle_node(node->index, new_block);
+
+      const int pos = subset_pos[node->index];
+      if (pos != -1 && (moved_subset.empty() || moved_subset.back() != pos)) {
+        moved_subset.push_back(pos);
+      }
+    }
+
+    // Pairs only change when one of their nodes moves. Compare each moved subset node
+    // with the rest of the subset using everyone's block as of the last sweep
+    std::sort(moved_subset.begin(), moved_subset.end());
+    moved_subset.erase(std::unique(moved_subset.begin(), moved_subset.end()), moved_subset.end());
+
+    auto subset_block_now = [&](const int pos) { return current_block[subset[pos]->index]; };
+    auto is_moved = [&](const int pos) {
+      return std::binary_search(moved_subset.begin(), moved_subset.end(), pos);
+    };
+
+    for (const int a : moved_subset) {
+      for (int b = 0; b < subset.size(); b++) {
+        if (b == a || (b < a && is_moved(b))) continue; // Pairs of moved nodes seen once
+
+        const bool was_together = subset_block[a] == subset_block[b];
+        const bool now_together = subset_block_now(a) == subset_block_now(b);
+        if (was_together == now_together) continue;
+
+        const std::uint64_t key = pair_key(a, b);
+        if (was_together) {
+          together_counts[key] += num_samples - together_since[key];
+          together_since.erase(key);
+        } else {
+          together_since[key] = num_samples;
+        }
+      }
+    }
+
+    for (const int pos : moved_subset) subset_block[pos] = subset_block_now(pos);
+
+    num_samples++;
+  }
+
+  // Getters
+  // ===========================================================================
+  int get_num_samples() const { return num_samples; }
+
+  int subset_size() const { return subset.size(); }
+
+  Memory_Usage memory_usage() const {
+    Memory_Usage usage;
+    usage.add_vector("node_states", current_block);
+    usage.add_vector("node_states", block_since);
+    usage.add_vector("block_counts", block_counts);
+    for (const auto& counts : block_counts) add_map(usage, "block_counts", counts);
+    usage.add_vector("subset", subset);
+    usage.add_vector("subset", subset_pos);
+    usage.add_vector("subset", subset_block);
+    add_map(usage, "pair_counts", together_since);
+    add_map(usage, "pair_counts", together_counts);
+    return usage;
+  }
+
+  // Proportion of samples each node spent in each block. Column major, one row per
+  // node index and one column per block index (up to `num_block_columns`).
+  Double_Vec block_marginals(const int num_block_columns) const {
+    const int num_nodes = current_block.size();
+    Double_Vec marginals(num_nodes * num_block_columns, 0.0);
+    if (num_samples == 0) return marginals;
+
+    auto add_samples = [&](const int node_i, const int block_i, const int count) {
+      if (block_i >= num_block_columns) stop("Block index past end of marginal matrix");
+      marginals[block_i * num_nodes + node_i] += double(count) / num_samples;
+    };
+
+    for (int node_i = 0; node_i < num_nodes; node_i++) {
+      for (const auto& block_count : block_counts[node_i]) {
+        add_samples(node_i, block_count.first, block_count.second);
+      }
+      add_samples(node_i, current_block[node_i], num_samples - block_since[node_i]);
+    }
+
+    return marginals;
+  }
+
+  // Proportion of samples each pair of subset nodes shared a block, in the order the
+  // subset was given. Column major and symmetric with ones on the diagonal.
+  Double_Vec co_occurrence() const {
+    const int n = subset.size();
+    Double_Vec proportions(n * n, 0.0);
+    if (num_samples == 0) return proportions;
+
+    auto add_samples = [&](const std::uint64_t key, const int count) {
+      const int a = key / n;
+      const int b = key % n;
+      proportions[a * n + b] += double(count) / num_samples;
+      proportions[b * n + a] += double(count) / num_samples;
+    };
+
+    for (const auto& pair_count : together_counts) add_samples(pair_count.first, pair_count.second);
+    for (const auto& open_pair : together_since) add_samples(open_pair.first, num_samples - open_pair.second);
+    for (int a = 0; a < n; a++) proportions[a * n + a] = 1.0;
+
+    return proportions;
+  }
+};
+
+#endif
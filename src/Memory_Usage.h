@@ -0,0 +1,122 @@
+#ifndef __MEMORY_USAGE_INCLUDED__
+#define __MEMORY_USAGE_INCLUDED__
+
+#include <map>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+// Heap memory held by a structure, split into named parts. Vectors are counted by
+// capacity rather than size so the numbers reflect what is actually allocated. Maps
+// are counted per node from the standard library's usual layout, which is close but
+// leaves out allocator bookkeeping, so treat totals as a lower bound on RSS.
+struct Memory_Part {
+  std::string name;
+  size_t bytes;
+  size_t allocations;
+
+  Memory_Part(const std::string& n, const size_t b, const size_t a)
+      : name(n), bytes(b), allocations(a) {}
+};
+
+class Memory_Usage {
+ private:
+  std::vector<Memory_Part> parts;
+
+ public:
+  // Adds to the part called `name`, starting it if it's new
+  void add(const std::string& name, const size_t bytes, const size_t allocations) {
+    for (auto& part : parts) {
+      if (part.name == name) {
+        part.bytes += bytes;
+        part.allocations += allocations;
+        return;
+      }
+    }
+    parts.emplace_back(name, bytes, allocations);
+  }
+
+  template <typename T>
+  void add_vector(const std::string& name, const std::vector<T>& vec) {
+    add(name, vec.capacity() * sizeof(T), vec.capacity() > 0);
+  }
+
+  // Folds in another structure's parts, named `prefix`_`part`
+  void add(const std::string& prefix, const Memory_Usage& other) {
+    for (const auto& part : other.parts) {
+      add(prefix + "_" + part.name, part.bytes, part.allocations);
+    }
+  }
+
+  const std::vector<Memory_Part>& get_parts() const { return parts; }
+
+  // Bytes of a single part, 0 if there's no part by that name
+  size_t bytes_of(const std::string& name) const {
+    for (const auto& part : parts) {
+      if (part.name == name) return part.bytes;
+    }
+    return 0;
+  }
+
+  size_t total_bytes() const {
+    size_t total = 0;
+    for (const auto& part : parts) total += part.bytes;
+    return total;
+  }
+
+  size_t total_allocations() const {
+    size_t total = 0;
+    for (const auto& part : parts) total += part.allocations;
+    return total;
+  }
+};
+
+// Heap bytes of a string's characters. Short strings live inside the string object.
+inline size_t string_heap_bytes(const std::string& str) {
+  const char* chars = str.data();
+  const char* object = reinterpret_cast<const char*>(&str);
+  const bool inline_chars = chars >= object && chars < object + sizeof(std::string);
+  return inline_chars ? 0 : str.capacity() + 1;
+}
+
+template <typename T>
+size_t key_heap_bytes(const T&) { return 0; }
+
+inline size_t key_heap_bytes(const std::string& key) { return string_heap_bytes(key); }
+
+// Red-black tree nodes carry a color and three pointers ahead of the value
+template <typename Key, typename Value, typename Compare>
+void add_map(Memory_Usage& usage,
+             const std::string& name,
+             const std::map<Key, Value, Compare>& map) {
+  size_t bytes = map.size() * (4 * sizeof(void*) + sizeof(std::pair<const Key, Value>));
+  size_t allocations = map.size();
+  for (const auto& entry : map) {
+    const size_t key_bytes = key_heap_bytes(entry.first);
+    bytes += key_bytes;
+    allocations += key_bytes > 0;
+  }
+  usage.add(name, bytes, allocations);
+}
+
+// Hash nodes carry a next pointer (and the hash itself for string keys), plus there's
+// the bucket array once the map has grown past its single built in bucket
+template <typename Key, typename Value, typename Hash>
+void add_map(Memory_Usage& usage,
+             const std::string& name,
+             const std::unordered_map<Key, Value, Hash>& map) {
+  const size_t cached_hash = std::is_same<Key, std::string>::value ? sizeof(size_t) : 0;
+  const bool bucket_array = map.bucket_count() > 1;
+  size_t bytes = (bucket_array ? map.bucket_count() * sizeof(void*) : 0) +
+                 map.size() * (sizeof(void*) + cached_hash + sizeof(std::pair<const Key, Value>));
+  size_t allocations = map.size() + bucket_array;
+  for (const auto& entry : map) {
+    const size_t key_bytes = key_heap_bytes(entry.first);
+    bytes += key_bytes;
+    allocations += key_bytes > 0;
+  }
+  usage.add(name, bytes, allocations);
+}
+
+#endif
@@ -0,0 +1,119 @@
+#ifndef __MOVE_CACHE_INCLUDED__
+#define __MOVE_CACHE_INCLUDED__
+
+#include "get_move_results.h"
+
+// Everything a move's score depends on, as version counters. Moving a node from block r
+// to s only reads the node's edges to blocks, rows r and s of the block edge counts (and
+// with them the degrees of r and s) and the degrees of the blocks the node connects to.
+// Row versions cover the rows and degrees, the node's neighborhood version covers its
+// edges to blocks and the sum of its neighbor blocks' versions covers their degrees
+// (versions only ever go up so the sum changes whenever any of them do).
+struct Move_Stamp {
+  const Node* old_block = nullptr;
+  unsigned old_version = 0;
+  unsigned new_version = 0;
+  unsigned neighborhood_version = 0;
+  unsigned long long neighbor_blocks_version = 0;
+
+  Move_Stamp() {}
+
+  Move_Stamp(const Node* node,
+             const Node* new_block,
+             const Block_Histogram& histogram,
+             const Block_Edge_Counts& block_counts)
+      : old_block(node->get_parent()),
+        old_version(block_counts.get_version(node->get_parent())),
+        new_version(block_counts.get_version(new_block)),
+        neighborhood_version(node->get_neighborhood_version()) {
+    for (const auto& count : histogram) {
+      neighbor_blocks_version += block_counts.get_version(count.first);
+    }
+  }
+
+  bool operator==(const Move_Stamp& other) const {
+    return old_block == other.old_block &&
+           old_version == other.old_version &&
+           new_version == other.new_version &&
+           neighborhood_version == other.neighborhood_version &&
+           neighbor_blocks_version == other.neighbor_blocks_version;
+  }
+};
+
+// The last few scored moves of every node. Late in a fit most proposals get rejected, so
+// a node keeps being offered the same handful of blocks with nothing around it having
+// changed. A lookup costs a pass over the node's neighbor blocks to build the stamp,
+// against a pass over two full block rows to score the move again.
+//
+// Each node has `slots_per_node` entries, replaced oldest first. Results depend on eps
+// as well so the cache needs clearing whenever that changes.
+class Move_Cache {
+ private:
+  struct Entry {
+    const Node* new_block = nullptr;
+    Move_Stamp stamp;
+    Move_Results results = Move_Results(0, 1);
+  };
+
+  int slots_per_node;
+  std::vector<Entry> entries;      // Node index x slot
+  std::vector<int> next_slot;      // By node index, the slot to replace next
+  long num_lookups = 0;
+  long num_hits = 0;
+
+ public:
+  explicit Move_Cache(const int num_nodes, const int slots = 4)
+      : slots_per_node(slots),
+        entries(num_nodes * slots),
+        next_slot(num_nodes, 0) {
+    if (slots < 1) stop("Move cache needs at least one slot per node");
+  }
+
+  // Cached results for moving `node` to `new_block`, or nullptr if there are none that
+  // are still good
+  const Move_Results* find(const Node* node, const Node* new_block, const Move_Stamp& stamp) {
+    num_lookups++;
+
+    const Entry* node_entries = &entries[node->index * slots_per_node];
+    for (int slot = 0; slot < slots_per_node; slot++) {
+      const Entry& entry = node_entries[slot];
+      if (entry.new_block == new_block && entry.stamp == stamp) {
+        num_hits++;
+        return &entry.results;
+      }
+    }
+    return nullptr;
+  }
+
+  void store(const Node* node,
+             const Node* new_block,
+             const Move_Stamp& stamp,
+             const Move_Results& results) {
+    int& slot = next_slot[node->index];
+    Entry& entry = entries[node->index * slots_per_node + slot];
+    entry.new_block = new_block;
+    entry.stamp = stamp;
+    entry.results = results;
+    slot = (slot + 1) % slots_per_node;
+  }
+
+  void clear() {
+    std::fill(entries.begin(), entries.end(), Entry());
+    std::fill(next_slot.begin(), next_slot.end(), 0);
+  }
+
+  long get_num_lookups() const { return num_lookups; }
+
+  long get_num_hits() const { return num_hits; }
+
+  double hit_rate() const { return num_lookups == 0 ? 0.0 : double(num_hits) / num_lookups; }
+
+  Memory_Usage memory_usage() const {
+    Memory_Usage usage;
+    usage.add_vector("entries", entries);
+    usage.add_vector("next_slots", next_slot);
+    return usage;
+  }
+};
+
+#endif
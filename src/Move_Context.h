@@ -0,0 +1,61 @@
+#ifndef __MOVE_CONTEXT_INCLUDED__
+#define __MOVE_CONTEXT_INCLUDED__
+
+#include "Edge_Container.h"
+#include "Node_Container.h"
+
+// Everything proposing and scoring a move needs to know about a node's type that only
+// changes when the number of blocks does. Keeping these around means the per-move setup
+// is a lookup rather than a walk over the neighbor types.
+struct Move_Context {
+  const Int_Vec* neighbor_types;  // Types nodes of this type can connect to
+  const Block_Edge_Counts* block_counts; // Edge counts between blocks
+  int n_potential_blocks;         // Blocks a node of this type could join
+  int n_possible_neighbors;       // Blocks across all the neighbor types
+  double eps;                     // Ergodicity parameter
+  double epsB;                    // eps times possible neighbor blocks
+  double ergo_amnt;               // eps times potential blocks
+
+  Move_Context(const int type,
+               const Node_Container& blocks,
+               const Edge_Container& edges,
+               const double eps_value)
+      : neighbor_types(&edges.neighbor_types_for_node(type)),
+        block_counts(&blocks.get_edge_counts()),
+        n_potential_blocks(blocks.size_of_type(type)),
+        n_possible_neighbors(0),
+        eps(eps_value) {
+
+    for (const int neighbor_type : *neighbor_types) {
+      n_possible_neighbors += blocks.size_of_type(neighbor_type);
+    }
+
+    epsB = eps * double(n_possible_neighbors);
+    ergo_amnt = eps * double(n_potential_blocks);
+  }
+};
+
+using Move_Contexts = std::vector<Move_Context>;
+
+// One context per node type, each with its own eps. Needs rebuilding whenever blocks
+// are added or removed
+inline Move_Contexts build_move_contexts(const Node_Container& blocks,
+                                         const Edge_Container& edges,
+                                         const std::vector<double>& eps_by_type) {
+  Move_Contexts contexts;
+  contexts.reserve(blocks.num_types());
+
+  for (int type_i = 0; type_i < blocks.num_types(); type_i++) {
+    contexts.emplace_back(type_i, blocks, edges, eps_by_type[type_i]);
+  }
+
+  return contexts;
+}
+
+inline Move_Contexts build_move_contexts(const Node_Container& blocks,
+                                         const Edge_Container& edges,
+                                         const double eps) {
+  return build_move_contexts(blocks, edges, std::vector<double>(blocks.num_types(), eps));
+}
+
+#endif
@@ -0,0 +1,101 @@
+#ifndef __NEIGHBOR_HISTOGRAMS_INCLUDED__
+#define __NEIGHBOR_HISTOGRAMS_INCLUDED__
+
+#include <algorithm>
+#include "Node_Container.h"
+
+using Edge_Count = std::pair<Node*, int>;
+
+// A node's edges to each block as a flat list of (block, count) pairs sorted by block
+// index. Same contents as `Node::get_block_edge_counts()` without a map node per block.
+struct Block_Histogram {
+  std::vector<Edge_Count> counts;
+  int self_edges = 0; // Times the node shows up in its own edges
+
+  Block_Histogram() {}
+
+  explicit Block_Histogram(const Node* node) { fill(node); }
+
+  template <int N_Types = 0>
+  void fill(const Node* node) {
+    counts.clear();
+    self_edges = 0;
+
+    node->for_each_neighbor<N_Types>([&](Node* neighbor) {
+      counts.emplace_back(neighbor->get_parent(), 1);
+      if (neighbor == node) self_edges++;
+    });
+
+    std::sort(counts.begin(), counts.end(), [](const Edge_Count& a, const Edge_Count& b) {
+      return a.first->index < b.first->index;
+    });
+
+    // Collapse runs of the same block into a single count
+    int num_blocks = 0;
+    for (const auto& count : counts) {
+      if (num_blocks > 0 && counts[num_blocks - 1].first == count.first) {
+        counts[num_blocks - 1].second++;
+      } else {
+        counts[num_blocks++] = count;
+      }
+    }
+    counts.resize(num_blocks);
+  }
+
+  int count_for(const Node* block) const {
+    const auto count_it = std::lower_bound(
+        counts.begin(), counts.end(), block->index,
+        [](const Edge_Count& count, const int index) { return count.first->index < index; });
+
+    return count_it != counts.end() && count_it->first == block ? count_it->second : 0;
+  }
+
+  std::vector<Edge_Count>::const_iterator begin() const { return counts.begin(); }
+  std::vector<Edge_Count>::const_iterator end() const { return counts.end(); }
+};
+
+// Every node's block histogram, built the first time it's asked for and kept until one
+// of the node's neighbors changes block. `swap_block()` bumps the neighborhood version
+// of every neighbor of the node it moves, so a stored histogram is good as long as its
+// version still matches the node's. Nodes in settled parts of the network get proposed
+// moves over and over without ever rebuilding.
+class Neighbor_Histograms {
+ private:
+  std::vector<Block_Histogram> histograms; // By node index
+  std::vector<unsigned> built_at_version;  // By node index, 0 for never built
+  long num_hits = 0;
+  long num_builds = 0;
+
+ public:
+  explicit Neighbor_Histograms(const int num_nodes)
+      : histograms(num_nodes), built_at_version(num_nodes, 0) {}
+
+  template <int N_Types = 0>
+  const Block_Histogram& get(const Node* node) {
+    Block_Histogram& histogram = histograms[node->index];
+
+    if (built_at_version[node->index] == node->get_neighborhood_version()) {
+      num_hits++;
+    } else {
+      histogram.fill<N_Types>(node);
+      built_at_version[node->index] = node->get_neighborhood_version();
+      num_builds++;
+    }
+
+    return histogram;
+  }
+
+  long get_num_hits() const { return num_hits; }
+
+  long get_num_builds() const { return num_builds; }
+
+  Memory_Usage memory_usage() const {
+    Memory_Usage usage;
+    usage.add_vector("histograms", histograms);
+    for (const auto& histogram : histograms) usage.add_vector("histogram_counts", histogram.counts);
+    usage.add_vector("versions", built_at_version);
+    return usage;
+  }
+};
+
+#endif
@@ -1,27 +1,45 @@
 #ifndef __NODE_INCLUDED__
 #define __NODE_INCLUDED__
 
-// [[Rcpp::plugins(cpp11)]]
-#include <Rcpp.h>
+#include <map>
 #include <vector>
 #include <random>
 
+#include "Memory_Usage.h"
+#include "String_Column.h"
 #include "vector_helpers.h"
 
-using namespace Rcpp;
 class Node;
 
 using Random_Engine = std::mt19937;
 using Node_Ptrs = std::vector<Node*>;
 using Node_Type_Vecs = std::vector<Node_Ptrs>;
-using Node_Edge_Counts = std::map<Node*, int>;
+
+// Orders nodes by index rather than address so anything summed over a set of
+// edge counts comes out the same from run to run
+struct Node_Index_Less {
+  bool operator()(const Node* a, const Node* b) const;
+};
+
+using Node_Edge_Counts = std::map<Node*, int, Node_Index_Less>;
 using string = std::string;
 
+// Hot path functions take the number of node types as a template parameter so the
+// unipartite (1) and bipartite (2) versions loop over a constant number of types and
+// can be unrolled. 0 means any number of types, looked up at run time.
+template <int N_Types>
+inline int fixed_num_types(const int run_time_num_types) {
+  return N_Types == 0 ? run_time_num_types : N_Types;
+}
+
 class Node {
  private:
   Node_Type_Vecs edges;        // Vector of pointers to every connected node
   Node* parent_ref = nullptr;  // Index of block or parent node in next-level's
                                // `Node_Container`
+  int degree = 0;              // Total number of edges, kept in sync with `edges`
+  std::vector<int> degrees_to_type;  // Number of edges to nodes of each type
+  unsigned neighborhood_version = 1; // Bumped whenever a neighbor changes block
 
  public:
   // Data
@@ -35,6 +53,7 @@ class Node {
   // Initialize the `index` and `type_index` data members
   Node(int i, int t, int n_t) : index(i), type_index(t) {
     edges = Node_Type_Vecs(n_t);
+    degrees_to_type = std::vector<int>(n_t, 0);
   }
 
   Node(const Node& copied_node) = delete;             // Copy constructor
@@ -43,15 +62,37 @@ class Node {
   Node& operator=(Node&& moved_node) = delete;        // Move assignment
 
   // Append to pointer to connected node to proper type edges vector
-  void add_edge(Node* node_ptr) { edges[node_ptr->type_index].push_back(node_ptr); }
+  void add_edge(Node* node_ptr) {
+    edges[node_ptr->type_index].push_back(node_ptr);
+    degrees_to_type[node_ptr->type_index]++;
+    degree++;
+  }
 
-  // Add a a whole set of edges in one go (e.g. when adding a child's edges to a block)
-  void add_edges(const Node_Type_Vecs& edges_to_add) {
-    for (int i = 0; i < edges.size(); i++) {
-      for (const auto& new_edge : edges_to_add[i]) {
-        edges[i].push_back(new_edge);
-      }
+  // Blocks don't keep lists of their children's edges, just the degrees. Add
+  // (`sign` = 1) or take away (`sign` = -1) a child's degrees.
+  template <int N_Types = 0>
+  void add_degrees_of(const Node* child, const int sign = 1) {
+    const int n_types = fixed_num_types<N_Types>(degrees_to_type.size());
+    for (int i = 0; i < n_types; i++) {
+      degrees_to_type[i] += sign * child->degrees_to_type[i];
     }
+    degree += sign * child->degree;
+  }
+
+  // Append a batch of edges to nodes of a single type (e.g. when building edges in bulk)
+  void append_edges_to_type(const int type, const Node_Ptrs& new_edges) {
+    edges[type].insert(edges[type].end(), new_edges.begin(), new_edges.end());
+    degrees_to_type[type] += new_edges.size();
+    degree += new_edges.size();
+  }
+
+  // Remove a single edge to connected node (e.g. when a child leaves a block)
+  void remove_edge(Node* node_ptr) {
+    if (!delete_from_vector(edges[node_ptr->type_index], node_ptr))
+      stop("Tried to remove an edge that doesn't exist");
+
+    degrees_to_type[node_ptr->type_index]--;
+    degree--;
   }
 
   void add_child(Node* child_node_ptr) { children.push_back(child_node_ptr); }
@@ -61,12 +102,18 @@ class Node {
   // Set the value of `parent_index` to a given integer
   void set_parent(Node* parent_node) { parent_ref = parent_node; }
 
+  void neighbor_moved() { neighborhood_version++; }
+
   // Getters
   // ===========================================================================
-  int get_degree() const { return total_num_elements(edges); }
+  int get_degree() const { return degree; }
+
+  int get_degree_to_type(const int type) const { return degrees_to_type[type]; }
 
   Node* get_parent() const { return parent_ref; }
 
+  unsigned get_neighborhood_version() const { return neighborhood_version; }
+
   int num_children() const { return children.size(); }
 
   const bool is_block() const { return index == -1; }
@@ -84,13 +131,34 @@ class Node {
     return types_w_nodes;
   }
 
-  Node_Type_Vecs& get_edges() { return edges;}
+  // Edges are only exposed read-only so the cached degrees can't fall out of sync
+  const Node_Type_Vecs& get_edges() const { return edges;}
+
+  const Node_Ptrs& get_edges_to_type(const int type) const { return edges.at(type); }
 
-  Node_Ptrs& get_edges_to_type(const int type) { return edges.at(type); }
+  void reserve_edges_to_type(const int type, const int n) { edges.at(type).reserve(n); }
 
-  Node_Edge_Counts get_block_edge_counts() {
+  // Reorder the edges to each type, e.g. to follow a new ordering of the nodes
+  template <typename Compare>
+  void sort_edges(const Compare& node_comes_before) {
+    for (auto& edges_of_type : edges) {
+      std::sort(edges_of_type.begin(), edges_of_type.end(), node_comes_before);
+    }
+  }
+
+  // Number of edges to each block. A block counts its children's edges.
+  Node_Edge_Counts get_block_edge_counts() const {
     Node_Edge_Counts counts;
 
+    if (!children.empty()) {
+      for (const Node* child : children) {
+        for (const auto& edges_of_type : child->edges) {
+          for (const auto& node : edges_of_type) counts[node->get_parent()]++;
+        }
+      }
+      return counts;
+    }
+
     for (const auto& edges_of_type : edges) {
       for (const auto& node : edges_of_type) {
         counts[node->get_parent()]++;
@@ -99,24 +167,59 @@ class Node {
     return counts;
   }
 
-  Node* get_random_neighbor(Random_Engine& random_engine) {
-    return get_random_element(edges, random_engine);
+  // Every edge is equally likely. The degree is already known so this is a single draw
+  // and a walk over at most `N_Types` edge vectors.
+  template <int N_Types = 0>
+  Node* get_random_neighbor(Random_Engine& random_engine) const {
+    if (degree == 0) stop("Can't take a random sample of empty vectors");
+
+    int edge_i = std::uniform_int_distribution<>(0, degree - 1)(random_engine);
+    if (N_Types == 1) return edges[0][edge_i];
+
+    const int n_types = fixed_num_types<N_Types>(edges.size());
+    for (int type_i = 0; type_i < n_types; type_i++) {
+      const int num_edges = edges[type_i].size();
+      if (edge_i < num_edges) return edges[type_i][edge_i];
+      edge_i -= num_edges;
+    }
+    stop("Random element could not be selected. Check formation of vectors");
+  }
+
+  // Calls `fn(neighbor)` for every edge, in order of type
+  template <int N_Types = 0, typename Neighbor_Fn>
+  void for_each_neighbor(const Neighbor_Fn& fn) const {
+    const int n_types = fixed_num_types<N_Types>(edges.size());
+    for (int type_i = 0; type_i < n_types; type_i++) {
+      for (Node* neighbor : edges[type_i]) fn(neighbor);
+    }
   }
 
-  string get_id(const CharacterVector& nodes_id) const {
+  string get_id(const String_Column& nodes_id) const {
     if (is_block())
       stop("Cant get id of block node");
     return string(nodes_id.at(index));
   }
 
-  string get_type(const CharacterVector& types_name) const {
+  string get_type(const String_Column& types_name) const {
     return string(types_name.at(type_index));
   }
 
+  // Heap held by the node's own vectors (the node object itself is its container's)
+  void add_memory_usage(Memory_Usage& usage) const {
+    usage.add_vector("edge_vectors", edges);
+    for (const auto& edges_of_type : edges) usage.add_vector("edge_vectors", edges_of_type);
+    usage.add_vector("degree_vectors", degrees_to_type);
+    usage.add_vector("child_lists", children);
+  }
+
   // Comparison operators
   // ===========================================================================
   bool operator==(const Node& b) const { return index == b.index; }
   bool operator<(const Node& b) const { return index < b.index; }
 };
 
+inline bool Node_Index_Less::operator()(const Node* a, const Node* b) const {
+  return a->index < b->index;
+}
+
 #endif
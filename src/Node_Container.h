@@ -1,14 +1,12 @@
 #ifndef __NODE_CONTAINER_INCLUDED__
 #define __NODE_CONTAINER_INCLUDED__
 
-// [[Rcpp::plugins(cpp11)]]
 #include <map>
 #include <memory>
 
-#include <Rcpp.h>
+#include "Block_Edge_Counts.h"
 #include "Node.h"
-
-using namespace Rcpp;
+#include "String_Lookup.h"
 
 // Two dimensional index for a Node in a node container
 struct Node_Loc {
@@ -30,12 +28,14 @@ using Node_Unique_Ptr = std::unique_ptr<Node>;
 using Node_Vec = std::vector<Node_Unique_Ptr>;
 using Node_Type_Vec = std::vector<Node_Vec>;
 using Id_to_Node_Map = std::unordered_map<string, Node*>;
+using Id_Lookup = String_Lookup<Node*>;
 
 class Node_Container {
  private:
   bool are_block_nodes = false;
   int block_index = 0; // Every time a block is added this increases, guarenteing we have unique indices for blocks
   int n_types;
+  Block_Edge_Counts block_edge_counts; // Only filled in for block containers
 
   const void check_for_type(const int type_i) const {
     if (type_i >= nodes.size())
@@ -48,6 +48,69 @@ class Node_Container {
     nodes[type_index].emplace_back(new Node(index, type_index, n_types));
   }
 
+  // Empty container, only used to build up copies
+  Node_Container() {}
+
+  // Start of a block container: `num_blocks` empty blocks for each child type
+  void add_empty_blocks(const int num_blocks, Node_Container& child_nodes) {
+    are_block_nodes = true;
+    n_types = child_nodes.num_types();
+    // Initialize `nodes` vec proper number of types
+    nodes = Node_Type_Vec(n_types);
+
+    for (int type_i = 0; type_i < n_types; type_i++) {
+      if (num_blocks > child_nodes.size_of_type(type_i)) {
+        stop("Can't initialize more blocks than there are nodes of a given type");
+      }
+
+      // Reserve elements for new nodes
+      nodes[type_i].reserve(num_blocks);
+
+      for (int i = 0; i < num_blocks; i++) {
+        // Build a new block node wrapped in smart pointer in it's type vector
+        add_node(block_index, type_i, n_types);
+        block_index++;
+      }
+    }
+  }
+
+  void assign_to_block(Node* child_node, Node* parent_block) {
+    child_node->set_parent(parent_block);
+
+    // Add child to parent block
+    parent_block->add_child(child_node);
+
+    // Blocks just take on the child's degrees, the edges are counted by block pairs
+    parent_block->add_degrees_of(child_node);
+  }
+
+  // Once every child has a parent, tally up the edges between blocks in one pass. Only
+  // types the children have edges between get room in a dense count matrix.
+  void tally_block_edge_counts(const Node_Container& child_nodes) {
+    block_edge_counts.set_num_types(n_types);
+    for (const auto& child_nodes_of_type : child_nodes.nodes) {
+      for (const auto& child_node : child_nodes_of_type) {
+        const Node_Type_Vecs& child_edges = child_node->get_edges();
+        for (int type_i = 0; type_i < n_types; type_i++) {
+          if (!child_edges[type_i].empty()) block_edge_counts.connect_types(child_node->type_index, type_i);
+        }
+      }
+    }
+
+    Node_Ptrs all_blocks;
+    all_blocks.reserve(size());
+    for (const auto& blocks_of_type : nodes) {
+      for (const auto& block : blocks_of_type) all_blocks.push_back(block.get());
+    }
+    block_edge_counts.add_blocks(all_blocks);
+
+    for (const auto& child_nodes_of_type : child_nodes.nodes) {
+      for (const auto& child_node : child_nodes_of_type) {
+        block_edge_counts.tally_child_edges(child_node.get());
+      }
+    }
+  }
+
  public:
   // Data
   Node_Type_Vec nodes;  // Vector of vectors type->nodes of type ordering
@@ -55,19 +118,25 @@ class Node_Container {
 
   // Setters
   // ===========================================================================
-  Node_Container(const CharacterVector& nodes_id,
-                 const CharacterVector& nodes_type,
-                 const CharacterVector& types_name,
-                 const IntegerVector& types_count){
+  // `types_count` is anything indexable with the number of nodes of each type (an R
+  // integer vector or a std::vector<int>), it's only used to size things up front
+  template <typename Type_Counts>
+  Node_Container(const String_Column& nodes_id,
+                 const String_Column& nodes_type,
+                 const String_Column& types_name,
+                 const Type_Counts& types_count){
     n_types = types_name.size();
 
     // Reserve proper number of sub vectors for nodes based on number of types
     nodes = Node_Type_Vec(n_types);
 
-    // Build a map to go from type name to index for faster look-up
+    // Build a map to go from type name to index for faster look-up. Node types are
+    // looked up by string address so they don't each need copying
+    String_Lookup<int> type_lookup(n_types);
     for (int i = 0; i < n_types; i++) {
       // Fill in type-to-index map entry for type
       type_to_index.emplace(types_name[i], i);
+      type_lookup.insert(types_name[i], i);
 
       // Reserve appropriate size for nodes vector for this type
       nodes[i].reserve(types_count[i]);
@@ -76,67 +145,111 @@ class Node_Container {
 
     for (int i = 0; i < nodes_id.size(); i++) {
       // Find index for type
-      const auto type_index_it = type_to_index.find(std::string(nodes_type[i]));
+      const int* type_index = type_lookup.find(nodes_type[i]);
 
       // Make sure it fits what we were given
-      if (type_index_it == type_to_index.end())
-        Rcpp::stop("Node " + string(nodes_id[i]) + " has type (" +
+      if (type_index == nullptr)
+        stop("Node " + string(nodes_id[i]) + " has type (" +
                    string(nodes_type[i]) +
                    ") not found in provided node types");
 
 
       // Build a new node wrapped in smart pointer in it's type vector
-      add_node(i, type_index_it->second, types_name.size());
+      add_node(i, *type_index, types_name.size());
     }
   }
 
   Node_Container(const int num_blocks,
                  Node_Container& child_nodes,
                  Random_Engine& random_engine) {
-    are_block_nodes = true;
-    n_types = child_nodes.num_types();
-    // Initialize `nodes` vec proper number of types
-    nodes = Node_Type_Vec(n_types);
+    add_empty_blocks(num_blocks, child_nodes);
 
     // Loop over types
     for (int type_i = 0; type_i < n_types; type_i++) {
       // Pull reference to children nodes of this type
       auto& child_nodes_of_type = child_nodes.get_nodes_of_type(type_i);
+      auto& blocks_for_type = nodes[type_i];
 
-      if (num_blocks > child_nodes_of_type.size()) {
-        stop("Can't initialize more blocks than there are nodes of a given type");
+      // Shuffle (pointers to) child nodes, leaving the child container's order alone
+      Node_Ptrs shuffled_children;
+      shuffled_children.reserve(child_nodes_of_type.size());
+      for (const auto& child_node : child_nodes_of_type) {
+        shuffled_children.push_back(child_node.get());
       }
+      std::shuffle(shuffled_children.begin(), shuffled_children.end(), random_engine);
 
-      // Reserve elements for new nodes
-      auto& blocks_for_type = nodes[type_i];
-      blocks_for_type.reserve(num_blocks);
+      // Loop through now shuffled children nodes
+      for (int i = 0; i < shuffled_children.size(); i++) {
+        // Add blocks one at a time, looping back after end to each node
+        assign_to_block(shuffled_children[i], blocks_for_type[i % num_blocks].get());
+      }
+    }
 
-      for (int i = 0; i < num_blocks; i++) {
-        // Build a new block node wrapped in smart pointer in it's type vector
-        add_node(block_index, type_i, n_types);
-        block_index++;
+    tally_block_edge_counts(child_nodes);
+  }
+
+  // Blocks from an already decided assignment: `block_of_node[i]` is which of its
+  // type's `num_blocks` blocks (0 based) the child node with index i goes in
+  Node_Container(const int num_blocks,
+                 Node_Container& child_nodes,
+                 const std::vector<int>& block_of_node) {
+    if (block_of_node.size() != child_nodes.size()) {
+      stop("Need a block for every node");
+    }
+
+    add_empty_blocks(num_blocks, child_nodes);
+
+    for (int type_i = 0; type_i < n_types; type_i++) {
+      for (const auto& child_node : child_nodes.get_nodes_of_type(type_i)) {
+        const int block_i = block_of_node[child_node->index];
+        if (block_i < 0 || block_i >= num_blocks) stop("Block assignment out of range");
+
+        assign_to_block(child_node.get(), nodes[type_i][block_i].get());
       }
+    }
 
-      // Shuffle child nodes
-      std::shuffle(child_nodes_of_type.begin(), child_nodes_of_type.end(),
-                   random_engine);
+    tally_block_edge_counts(child_nodes);
+  }
 
-      // Loop through now shuffled children nodes
-      for (int i = 0; i < child_nodes_of_type.size(); i++) {
-        Node* parent_block = blocks_for_type[i % num_blocks].get();
-        Node* child_node = child_nodes_of_type[i].get();
+  // Deep copy of a network's nodes along with the edges between them. The copy
+  // has its own parent pointers so it can be assigned to blocks independently
+  // of the original (e.g. one copy per chain) without going back to string ids.
+  Node_Container clone() const {
+    if (are_block_nodes) stop("Can't clone block nodes");
 
-        // Add blocks one at a time, looping back after end to each node
-        child_node->set_parent(parent_block);
+    Node_Container copy;
+    copy.n_types = n_types;
+    copy.type_to_index = type_to_index;
+    copy.nodes = Node_Type_Vec(n_types);
 
-        // Add child to parent block
-        parent_block->add_child(child_node);
+    // Node index -> its copy so edges can be pointed at the new nodes
+    std::vector<Node*> copy_by_index(size(), nullptr);
 
-        // Dump all the edges from child to this parent
-        parent_block->add_edges(child_node->get_edges());
-      }  // End block to child node assignment
-    }    // End loop over node types
-  }      // End constructor
+    for (int type_i = 0; type_i < n_types; type_i++) {
+      copy.nodes[type_i].reserve(nodes[type_i].size());
+
+      for (const auto& node : nodes[type_i]) {
+        copy.add_node(node->index, type_i, n_types);
+        copy_by_index[node->index] = copy.nodes[type_i].back().get();
+      }
+    }
+
+    for (const auto& type_vec : nodes) {
+      for (const auto& node : type_vec) {
+        Node* node_copy = copy_by_index[node->index];
+        const Node_Type_Vecs& node_edges = node->get_edges();
+
+        for (int type_i = 0; type_i < n_types; type_i++) {
+          node_copy->reserve_edges_to_type(type_i, node_edges[type_i].size());
+          for (const auto& neighbor : node_edges[type_i]) {
+            node_copy->add_edge(copy_by_index[neighbor->index]);
+          }
+        }
+      }
+    }
+
+    return copy;
+  }
 
   // Getters
   // ===========================================================================
@@ -166,11 +279,31 @@ class Node_Container {
 
   int size() const { return total_num_elements(nodes); }
 
+  // Edge counts between every pair of blocks in a block container
+  Block_Edge_Counts& get_edge_counts() { return block_edge_counts; }
+
+  const Block_Edge_Counts& get_edge_counts() const { return block_edge_counts; }
+
   int num_types() const { return n_types; }
 
   bool is_multipartite() const { return n_types > 1; }
 
-  Id_to_Node_Map get_id_to_node_map(const CharacterVector& nodes_id) {
+  // Heap held by the nodes and everything they own. Block containers also report their
+  // block edge counts, as `edge_counts_*` parts.
+  Memory_Usage memory_usage() const {
+    Memory_Usage usage;
+    usage.add("node_objects", size() * sizeof(Node), size());
+    usage.add_vector("node_vectors", nodes);
+    for (const auto& nodes_of_type : nodes) {
+      usage.add_vector("node_vectors", nodes_of_type);
+      for (const auto& node : nodes_of_type) node->add_memory_usage(usage);
+    }
+    add_map(usage, "type_map", type_to_index);
+    if (are_block_nodes) usage.add("edge_counts", block_edge_counts.memory_usage());
+    return usage;
+  }
+
+  Id_to_Node_Map get_id_to_node_map(const String_Column& nodes_id) {
 
     if(are_block_nodes) stop("Can't get ids to block nodes");
 
@@ -184,6 +317,22 @@ class Node_Container {
 
     return id_to_loc;
   }
+
+  // Same as `get_id_to_node_map()` but keyed on string addresses, see `String_Lookup`
+  Id_Lookup get_id_lookup(const String_Column& nodes_id) const {
+
+    if(are_block_nodes) stop("Can't get ids to block nodes");
+
+    Id_Lookup id_lookup(size());
+
+    for (const auto& type_vec : nodes) {
+      for (const auto& node : type_vec) {
+        id_lookup.insert(nodes_id[node->index], node.get());
+      }
+    }
+
+    return id_lookup;
+  }
 };
 
 #endif
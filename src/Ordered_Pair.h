@@ -1,6 +1,11 @@
 #ifndef __ORDERED_PAIR_INCLUDED__
 #define __ORDERED_PAIR_INCLUDED__
 
+#include <cstddef>
+#include <functional>
+#include <unordered_set>
+#include <utility>
+
 template<typename T>
 T * ptr(T & obj) { return &obj; } //turn reference into pointer!
 
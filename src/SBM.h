@@ -0,0 +1,186 @@
+#ifndef __SBM_INCLUDED__
+#define __SBM_INCLUDED__
+
+#include "Edge_Container.h"
+#include "Move_Cache.h"
+#include "Sweep_Scheduler.h"
+#include "calc_entropy.h"
+#include "export_blocks.h"
+#include "get_move_results.h"
+#include "initial_blocks.h"
+#include "propose_move.h"
+#include "swap_blocks.h"
+
+struct Sweep_Results {
+  int num_nodes_visited = 0;
+  int num_nodes_moved = 0;
+  double entropy_delta = 0.0;
+  Node_Ptrs moved_nodes; // In the order they moved
+  Int_Vec proposed_by_type; // Proposals to a different block, by node type
+  Int_Vec moved_by_type;    // Accepted moves, by node type
+};
+
+// A single chain of the model: its own copy of the network's nodes, the blocks
+// they are assigned to and a random engine. The edge container is only ever
+// read so it can be shared between every chain fit on the same network.
+class SBM {
+ private:
+  Node_Container nodes;
+  Random_Engine random_engine;
+  Node_Container blocks;
+  const Edge_Container& edges;
+  Move_Contexts move_contexts; // Per node type, rebuilt if the blocks or eps change
+  Sweep_Scheduler scheduler;
+  Neighbor_Histograms histograms; // Each node's edges to blocks, kept between sweeps
+  Move_Cache move_cache;          // Recently scored moves of each node
+  int fixed_types;                // Types the sweep kernel is built for, 0 for any number
+
+  // Unipartite and bipartite networks get their own sweep kernels, picked once here
+  static int kernel_num_types(const int num_types) { return num_types <= 2 ? num_types : 0; }
+
+  // Score a move, reusing the last result for the same move if nothing it depends on
+  // has changed since
+  template <int N_Types>
+  Move_Results score_move(Node* node, Node* new_block, const Move_Context& context) {
+    const Block_Histogram& histogram = histograms.get<N_Types>(node);
+    const Move_Stamp stamp(node, new_block, histogram, blocks.get_edge_counts());
+
+    const Move_Results* cached = move_cache.find(node, new_block, stamp);
+    if (cached != nullptr) return *cached;
+
+    const Move_Results move = Move_Evaluator(node, context, histogram).evaluate(new_block);
+    move_cache.store(node, new_block, stamp, move);
+    return move;
+  }
+
+  // One pass over the nodes the scheduler picks, with the number of types fixed
+  template <int N_Types>
+  void sweep_nodes(const double beta, Sweep_Results& results) {
+    std::uniform_real_distribution<> runif;
+
+    for (Node* node : scheduler.next_sweep(random_engine)) {
+      results.num_nodes_visited++;
+
+      const Move_Context& context = move_contexts[node->type_index];
+      Node* old_block = node->get_parent();
+      Node* new_block = propose_move<N_Types>(node, blocks, random_engine, context);
+
+      if (new_block == old_block) continue;
+      results.proposed_by_type[node->type_index]++;
+
+      const Move_Results move = score_move<N_Types>(node, new_block, context);
+
+      // Metropolis-Hastings acceptance of the (entropy decreasing) move
+      const double accept_prob = std::exp(-beta * move.entropy_delta) * move.prob_ratio;
+
+      if (runif(random_engine) < accept_prob) {
+        // Empty blocks are kept so the number of blocks stays fixed
+        swap_block<N_Types>(node, new_block, blocks, false);
+        scheduler.node_moved(node);
+        results.num_nodes_moved++;
+        results.moved_by_type[node->type_index]++;
+        results.moved_nodes.push_back(node);
+        results.entropy_delta += move.entropy_delta;
+      }
+    }
+  }
+
+ public:
+  // Setters
+  // ===========================================================================
+  SBM(const Node_Container& network,
+      const Edge_Container& network_edges,
+      const int num_blocks,
+      const Random_Engine& engine,
+      const Sweep_Order sweep_order = Sweep_Order::fixed,
+      const Block_Init block_init = Block_Init::random,
+      const int init_threads = 1)
+      : nodes(network.clone()),
+        random_engine(engine),
+        blocks(initial_blocks(num_blocks, nodes, random_engine, block_init, init_threads)),
+        edges(network_edges),
+        move_contexts(build_move_contexts(blocks, edges, 0.1)),
+        scheduler(nodes, sweep_order),
+        histograms(nodes.size()),
+        move_cache(nodes.size()),
+        fixed_types(kernel_num_types(nodes.num_types())) {}
+
+  // Starts from blocks already decided on: `block_of_node[i]` is the block (0 based
+  // within its type) of the node with index i
+  SBM(const Node_Container& network,
+      const Edge_Container& network_edges,
+      const int num_blocks,
+      const Int_Vec& block_of_node,
+      const Random_Engine& engine,
+      const Sweep_Order sweep_order = Sweep_Order::fixed)
+      : nodes(network.clone()),
+        random_engine(engine),
+        blocks(num_blocks, nodes, block_of_node),
+        edges(network_edges),
+        move_contexts(build_move_contexts(blocks, edges, 0.1)),
+        scheduler(nodes, sweep_order),
+        histograms(nodes.size()),
+        move_cache(nodes.size()),
+        fixed_types(kernel_num_types(nodes.num_types())) {}
+
+  SBM(const SBM& copied_sbm) = delete;
+  SBM& operator=(const SBM& copied_sbm) = delete;
+
+  // Attempt a move for every node in the network once (or every node the sweep
+  // scheduler picks). `beta` is the inverse temperature: values below 1 make
+  // entropy increasing moves more likely.
+  Sweep_Results mcmc_sweep(const double eps = 0.1, const double beta = 1.0) {
+    return mcmc_sweep(std::vector<double>(nodes.num_types(), eps), beta);
+  }
+
+  // Same as above with a separate eps for each node type
+  Sweep_Results mcmc_sweep(const std::vector<double>& eps_by_type, const double beta) {
+    Sweep_Results results;
+    results.proposed_by_type = Int_Vec(nodes.num_types(), 0);
+    results.moved_by_type = Int_Vec(nodes.num_types(), 0);
+
+    if (eps_by_type.size() != nodes.num_types()) stop("Need an eps for every node type");
+
+    bool eps_changed = false;
+    for (int type_i = 0; type_i < nodes.num_types(); type_i++) {
+      eps_changed = eps_changed || move_contexts[type_i].eps != eps_by_type[type_i];
+    }
+    if (eps_changed) {
+      move_contexts = build_move_contexts(blocks, edges, eps_by_type);
+      move_cache.clear();
+    }
+
+    switch (fixed_types) {
+      case 1: sweep_nodes<1>(beta, results); break;
+      case 2: sweep_nodes<2>(beta, results); break;
+      default: sweep_nodes<0>(beta, results);
+    }
+
+    return results;
+  }
+
+  // Getters
+  // ===========================================================================
+  double entropy() { return calc_entropy(blocks); }
+
+  // Index of each node's block, in order of the node's index (input order)
+  Int_Vec block_assignments() const {
+    Int_Vec assignments(nodes.size());
+    write_block_assignments(nodes, assignments.begin());
+    return assignments;
+  }
+
+  Node_Container& get_nodes() { return nodes; }
+
+  Node_Container& get_blocks() { return blocks; }
+
+  Neighbor_Histograms& get_histograms() { return histograms; }
+
+  const Neighbor_Histograms& get_histograms() const { return histograms; }
+
+  const Move_Cache& get_move_cache() const { return move_cache; }
+
+  const Sweep_Scheduler& get_scheduler() const { return scheduler; }
+};
+
+#endif
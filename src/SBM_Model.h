@@ -0,0 +1,121 @@
+#ifndef __SBM_MODEL_INCLUDED__
+#define __SBM_MODEL_INCLUDED__
+
+#include <memory>
+#include "Marginal_Accumulator.h"
+#include "reorder_nodes.h"
+#include "run_chains.h"
+
+// A single chain that lives between calls from R. It owns the network it was built
+// from so ingesting the nodes and edges happens once, no matter how many times the
+// chain is swept or inspected afterwards. The chain holds a reference to the edges so
+// a model must stay where it was created (it lives behind an external pointer in R).
+class SBM_Model {
+ private:
+  Node_Container network;
+  Edge_Container edges;
+  std::unique_ptr<SBM> sbm;
+  Double_Vec entropy_trace; // Entropy at creation and after every sweep
+  std::unique_ptr<Marginal_Accumulator> marginals; // Only once asked for
+
+ public:
+  // Setters
+  // ===========================================================================
+  // Uses the same random stream as the first chain of `run_chains()` with this seed
+  template <typename Type_Counts>
+  SBM_Model(const String_Column& nodes_id,
+            const String_Column& nodes_type,
+            const String_Column& types_name,
+            const Type_Counts& types_count,
+            const String_Column& edges_from,
+            const String_Column& edges_to,
+            const int num_blocks,
+            const int seed = 42,
+            const Sweep_Order sweep_order = Sweep_Order::fixed,
+            const Node_Order node_order = Node_Order::input,
+            const Block_Init block_init = Block_Init::random,
+            const int num_threads = 1)
+      : network(nodes_id, nodes_type, types_name, types_count),
+        edges(edges_from, edges_to, nodes_id, network, {}, {}, num_threads) {
+    reorder_nodes(network, node_order);
+
+    sbm.reset(new SBM(network, edges, num_blocks, chain_random_engine(seed, 0), sweep_order,
+                      block_init, num_threads));
+    entropy_trace.push_back(sbm->entropy());
+  }
+
+  SBM_Model(const SBM_Model& copied_model) = delete;
+  SBM_Model& operator=(const SBM_Model& copied_model) = delete;
+
+  // Returns the entropy after each of the new sweeps
+  Double_Vec run_sweeps(const int num_sweeps, const double eps = 0.1, const double beta = 1.0) {
+    if (num_sweeps < 0) stop("Can't run a negative number of sweeps");
+
+    Double_Vec new_entropies;
+    new_entropies.reserve(num_sweeps);
+    entropy_trace.reserve(entropy_trace.size() + num_sweeps);
+
+    for (int i = 0; i < num_sweeps; i++) {
+      const Sweep_Results sweep = sbm->mcmc_sweep(eps, beta);
+      entropy_trace.push_back(entropy_trace.back() + sweep.entropy_delta);
+      new_entropies.push_back(entropy_trace.back());
+
+      if (marginals) marginals->record_sweep(sweep.moved_nodes);
+    }
+
+    return new_entropies;
+  }
+
+  // Start (or restart) tallying block memberships over the sweeps run from now on,
+  // e.g. once burn-in is done. Pairs are tracked for nodes at `subset_indices`.
+  void start_marginals(const Int_Vec& subset_indices = {}) {
+    marginals.reset(new Marginal_Accumulator(sbm->get_nodes(), subset_indices));
+  }
+
+  // Getters
+  // ===========================================================================
+  const Marginal_Accumulator& get_marginals() const {
+    if (!marginals) stop("Marginals haven't been started for this model");
+    return *marginals;
+  }
+
+  // One past the highest block index, the width of a block marginal matrix
+  int num_block_columns() { return block_index_span(sbm->get_blocks()); }
+
+  double entropy() const { return entropy_trace.back(); }
+
+  const Double_Vec& get_entropy_trace() const { return entropy_trace; }
+
+  int num_sweeps() const { return entropy_trace.size() - 1; }
+
+  int num_blocks() { return sbm->get_blocks().size(); }
+
+  int num_nodes() const { return network.size(); }
+
+  Int_Vec block_assignments() const { return sbm->block_assignments(); }
+
+  const Node_Container& get_nodes() const { return sbm->get_nodes(); }
+
+  const Node_Container& get_blocks() const { return sbm->get_blocks(); }
+
+  Neighbor_Histograms& get_histograms() { return sbm->get_histograms(); }
+
+  const Move_Cache& get_move_cache() const { return sbm->get_move_cache(); }
+
+  // Heap held by the network's nodes and edges, the chain's own copy of the nodes, its
+  // blocks, its per node caches and sweep schedule, and the marginals once started
+  std::vector<std::pair<string, Memory_Usage>> memory_usage() const {
+    std::vector<std::pair<string, Memory_Usage>> usage{
+        {"nodes", network.memory_usage()},
+        {"edges", edges.memory_usage()},
+        {"chain_nodes", sbm->get_nodes().memory_usage()},
+        {"blocks", sbm->get_blocks().memory_usage()},
+        {"histograms", sbm->get_histograms().memory_usage()},
+        {"move_cache", sbm->get_move_cache().memory_usage()},
+        {"scheduler", sbm->get_scheduler().memory_usage()}};
+    if (marginals) usage.emplace_back("marginals", marginals->memory_usage());
+    return usage;
+  }
+};
+
+#endif
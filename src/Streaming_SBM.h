@@ -0,0 +1,297 @@
+#ifndef __STREAMING_SBM_INCLUDED__
+#define __STREAMING_SBM_INCLUDED__
+
+#include <numeric>
+#include <random>
+#include "Mapped_Adjacency.h"
+#include "SBM.h"
+
+// A chain fit against a memory-mapped adjacency rather than `Node`s. The edges stay on
+// disk; all that's held in memory is each node's block and the block-level counts
+// (degrees and edges between every pair of blocks), so memory use is O(N + B^2)
+// whatever the number of edges. Sweeps visit nodes in file order so the mapped
+// neighbor lists are read front to back.
+//
+// Moves are proposed and scored with the same rules as `SBM`, worked out from the
+// counts directly: a node's neighbors' blocks are its only per-move reads of the file.
+// Blocks of type t are numbered t * num_blocks to (t + 1) * num_blocks - 1.
+class Streaming_SBM {
+ private:
+  const Mapped_Adjacency& adjacency;
+  Random_Engine random_engine;
+  int num_blocks;                   // Per type
+  int total_blocks;
+  Int_Vec block_of;                 // By node position
+  Int_Vec block_degree;             // Edge ends of all children
+  Int_Vec block_degree_to_type;     // Block x type
+  Int_Vec counts;                   // Block x block edge ends (e_rs), dense
+  Int_Vec n_possible_neighbors;     // By type, blocks across the types it connects to
+
+  // Scratch space for a node's edges to each block
+  Int_Vec node_to_block;            // By block, zero outside of a move
+  Int_Vec touched_blocks;           // Blocks with nonzero entries in `node_to_block`
+  mutable Entropy_Terms terms;
+
+  int& count(const int r, const int s) { return counts[r * total_blocks + s]; }
+  int count(const int r, const int s) const { return counts[r * total_blocks + s]; }
+
+  int first_block_of_type(const int type) const { return type * num_blocks; }
+
+  void gather_node_edges(const int pos) {
+    for (const std::int32_t* nbr = adjacency.neighbors_begin(pos); nbr != adjacency.neighbors_end(pos); nbr++) {
+      const int block = block_of[*nbr];
+      if (node_to_block[block]++ == 0) touched_blocks.push_back(block);
+    }
+  }
+
+  void clear_node_edges() {
+    for (const int block : touched_blocks) node_to_block[block] = 0;
+    touched_blocks.clear();
+  }
+
+  int self_edges(const int pos) const {
+    int num_self = 0;
+    for (const std::int32_t* nbr = adjacency.neighbors_begin(pos); nbr != adjacency.neighbors_end(pos); nbr++) {
+      if (*nbr == pos) num_self++;
+    }
+    return num_self;
+  }
+
+  // Same proposal as `propose_move()`: a random neighbor's block t, then either a
+  // random block of the node's type or the block at the end of a random edge from t
+  // to the node's type
+  int propose(const int pos, const double eps) {
+    const int type = adjacency.node_type(pos);
+    const int degree = adjacency.degree(pos);
+    const int first = first_block_of_type(type);
+
+    const int neighbor = adjacency.neighbors_begin(pos)[
+      std::uniform_int_distribution<int>(0, degree - 1)(random_engine)];
+    const int neighbor_block = block_of[neighbor];
+
+    const int edges_to_type = block_degree_to_type[neighbor_block * adjacency.num_types() + type];
+    const double ergo_amnt = eps * num_blocks;
+    const double prob_of_random_block = ergo_amnt / (edges_to_type + ergo_amnt);
+
+    if (std::uniform_real_distribution<>()(random_engine) < prob_of_random_block) {
+      return first + std::uniform_int_distribution<int>(0, num_blocks - 1)(random_engine);
+    }
+
+    int edge_end = std::uniform_int_distribution<int>(0, edges_to_type - 1)(random_engine);
+    for (int block = first; block < first + num_blocks; block++) {
+      edge_end -= count(neighbor_block, block);
+      if (edge_end < 0) return block;
+    }
+    return first + num_blocks - 1;
+  }
+
+  // Entropy delta and probability ratio of moving the node at `pos` (whose edges are
+  // gathered in `node_to_block`) from block r to block s
+  Move_Results evaluate(const int pos, const int r, const int s, const double eps) const {
+    const int type = adjacency.node_type(pos);
+    const double degree = adjacency.degree(pos);
+    const int m = self_edges(pos);
+    const int k_r = node_to_block[r] - m; // Edges to the rest of the old block
+    const int k_s = node_to_block[s];
+
+    const double d_r = block_degree[r];
+    const double d_s = block_degree[s];
+    const double d_r_post = d_r - degree;
+    const double d_s_post = d_s + degree;
+
+    // Only pairs involving r or s change. Pairs with one end outside are seen twice in
+    // the full sum (once from each side) and pairs inside once each way
+    terms.clear();
+    for (int b = 0; b < total_blocks; b++) {
+      if (b == r || b == s) continue;
+      const double d_b = block_degree[b];
+      const int k_b = node_to_block[b];
+
+      terms.add(count(r, b), d_r, d_b, 1.0);
+      terms.add(count(s, b), d_s, d_b, 1.0);
+      terms.add(count(r, b) - k_b, d_r_post, d_b, -1.0);
+      terms.add(count(s, b) + k_b, d_s_post, d_b, -1.0);
+    }
+
+    terms.add(count(r, r), d_r, d_r, 0.5);
+    terms.add(count(s, s), d_s, d_s, 0.5);
+    terms.add(count(r, s), d_r, d_s, 1.0);
+    terms.add(count(r, r) - 2 * k_r - m, d_r_post, d_r_post, -0.5);
+    terms.add(count(s, s) + 2 * k_s + m, d_s_post, d_s_post, -0.5);
+    terms.add(count(r, s) - k_s + k_r, d_r_post, d_s_post, -1.0);
+
+    const double entropy_delta = sum_entropy_terms(terms);
+
+    // Probability of proposing s now and r once the node is in s
+    const double epsB = eps * n_possible_neighbors[type];
+    double prob_move_to_new = 0.0;
+    double prob_return_to_old = 0.0;
+
+    for (const int t : touched_blocks) {
+      const double prop_of_edges = node_to_block[t] / degree;
+      const double d_t_post = t == r ? d_r_post : t == s ? d_s_post : block_degree[t];
+      const int t_to_old_post = t == r ? count(r, r) - 2 * k_r - m
+                              : t == s ? count(s, r) - k_s + k_r
+                              : count(t, r) - node_to_block[t];
+
+      prob_move_to_new += prop_of_edges * (count(t, s) + eps) / (block_degree[t] + epsB);
+      prob_return_to_old += prop_of_edges * (t_to_old_post + eps) / (d_t_post + epsB);
+    }
+
+    return Move_Results(entropy_delta, prob_return_to_old / prob_move_to_new);
+  }
+
+  void apply_move(const int pos, const int r, const int s) {
+    const int degree = adjacency.degree(pos);
+    const int n_types = adjacency.num_types();
+
+    for (const std::int32_t* nbr = adjacency.neighbors_begin(pos); nbr != adjacency.neighbors_end(pos); nbr++) {
+      const int neighbor_type = adjacency.node_type(*nbr);
+      block_degree_to_type[r * n_types + neighbor_type]--;
+      block_degree_to_type[s * n_types + neighbor_type]++;
+
+      if (*nbr == pos) {
+        count(r, r)--;
+        count(s, s)++;
+      } else {
+        const int b = block_of[*nbr];
+        count(r, b)--;
+        count(b, r)--;
+        count(s, b)++;
+        count(b, s)++;
+      }
+    }
+
+    block_degree[r] -= degree;
+    block_degree[s] += degree;
+    block_of[pos] = s;
+  }
+
+ public:
+  // Setters
+  // ===========================================================================
+  // Nodes of each type are shuffled and dealt out to `num_blocks` blocks, as with
+  // random starting blocks for `SBM`
+  Streaming_SBM(const Mapped_Adjacency& mapped_adjacency,
+                const int blocks_per_type,
+                const Random_Engine& engine)
+      : adjacency(mapped_adjacency),
+        random_engine(engine),
+        num_blocks(blocks_per_type),
+        total_blocks(blocks_per_type * mapped_adjacency.num_types()),
+        block_of(mapped_adjacency.num_nodes()),
+        block_degree(total_blocks, 0),
+        block_degree_to_type(total_blocks * mapped_adjacency.num_types(), 0),
+        counts(std::size_t(total_blocks) * total_blocks, 0),
+        n_possible_neighbors(mapped_adjacency.num_types(), 0),
+        node_to_block(total_blocks, 0) {
+    const int n_types = adjacency.num_types();
+
+    for (int type = 0; type < n_types; type++) {
+      for (int other = 0; other < n_types; other++) {
+        if (adjacency.type_edges(type, other) > 0) n_possible_neighbors[type] += num_blocks;
+      }
+    }
+
+    // Nodes are grouped by type in the file so each type is a contiguous run
+    int type_start = 0;
+    for (int type = 0; type < n_types; type++) {
+      int type_end = type_start;
+      while (type_end < adjacency.num_nodes() && adjacency.node_type(type_end) == type) type_end++;
+
+      if (num_blocks > type_end - type_start) {
+        stop("Can't initialize more blocks than there are nodes of a given type");
+      }
+
+      Int_Vec shuffled(type_end - type_start);
+      std::iota(shuffled.begin(), shuffled.end(), type_start);
+      std::shuffle(shuffled.begin(), shuffled.end(), random_engine);
+      for (int i = 0; i < shuffled.size(); i++) {
+        block_of[shuffled[i]] = first_block_of_type(type) + i % num_blocks;
+      }
+
+      type_start = type_end;
+    }
+
+    // One streaming pass to fill in the block level counts
+    for (int pos = 0; pos < adjacency.num_nodes(); pos++) {
+      const int block = block_of[pos];
+      block_degree[block] += adjacency.degree(pos);
+
+      for (const std::int32_t* nbr = adjacency.neighbors_begin(pos); nbr != adjacency.neighbors_end(pos); nbr++) {
+        count(block, block_of[*nbr])++;
+        block_degree_to_type[block * n_types + adjacency.node_type(*nbr)]++;
+      }
+    }
+  }
+
+  Streaming_SBM(const Streaming_SBM& copied) = delete;
+  Streaming_SBM& operator=(const Streaming_SBM& copied) = delete;
+
+  // Attempt a move for every connected node, in file order. `moved_nodes` is left
+  // empty as there are no `Node`s to point at.
+  Sweep_Results mcmc_sweep(const double eps = 0.1, const double beta = 1.0) {
+    Sweep_Results results;
+    std::uniform_real_distribution<> runif;
+
+    for (int pos = 0; pos < adjacency.num_nodes(); pos++) {
+      if (adjacency.degree(pos) == 0) continue;
+      results.num_nodes_visited++;
+
+      const int old_block = block_of[pos];
+      const int new_block = propose(pos, eps);
+      if (new_block == old_block) continue;
+
+      gather_node_edges(pos);
+      const Move_Results move = evaluate(pos, old_block, new_block, eps);
+
+      // Metropolis-Hastings acceptance of the (entropy decreasing) move
+      const double accept_prob = std::exp(-beta * move.entropy_delta) * move.prob_ratio;
+
+      if (runif(random_engine) < accept_prob) {
+        apply_move(pos, old_block, new_block);
+        results.num_nodes_moved++;
+        results.entropy_delta += move.entropy_delta;
+      }
+      clear_node_edges();
+    }
+
+    return results;
+  }
+
+  // Entropy delta and probability ratio of moving the node at `pos` to `new_block`,
+  // without moving it
+  Move_Results score_move(const int pos, const int new_block, const double eps = 0.1) {
+    gather_node_edges(pos);
+    const Move_Results move = evaluate(pos, block_of[pos], new_block, eps);
+    clear_node_edges();
+    return move;
+  }
+
+  // Getters
+  // ===========================================================================
+  double entropy() const {
+    terms.clear();
+    for (int r = 0; r < total_blocks; r++) {
+      for (int s = 0; s < total_blocks; s++) {
+        terms.add(count(r, s), block_degree[r], block_degree[s], -0.5);
+      }
+    }
+    return sum_entropy_terms(terms);
+  }
+
+  // Block of each node, in order of the original `nodes_id`
+  Int_Vec block_assignments() const {
+    Int_Vec assignments(adjacency.num_nodes());
+    for (int pos = 0; pos < adjacency.num_nodes(); pos++) {
+      assignments[adjacency.node_index(pos)] = block_of[pos];
+    }
+    return assignments;
+  }
+
+  int get_count(const int r, const int s) const { return count(r, s); }
+
+  int get_block_degree(const int block) const { return block_degree[block]; }
+};
+
+#endif
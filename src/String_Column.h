@@ -0,0 +1,68 @@
+#ifndef __STRING_COLUMN_INCLUDED__
+#define __STRING_COLUMN_INCLUDED__
+
+#include <initializer_list>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include "error_helpers.h"
+
+// What a `String_Column` can be built from. Specializations provide
+// `static void append(const Source&, std::vector<const char*>&)`; the R adapter adds
+// one for character vectors.
+template <typename Source>
+struct String_Source {};
+
+template <>
+struct String_Source<std::vector<std::string>> {
+  static void append(const std::vector<std::string>& source, std::vector<const char*>& strings) {
+    for (const auto& s : source) strings.push_back(s.c_str());
+  }
+};
+
+// A column of strings (node ids, node types, edge ends) as pointers to their
+// characters, which is all the model code sees of strings from outside. The characters
+// belong to the source so it has to outlive the column. Sources that keep a single copy
+// of every distinct string (R's string cache, a `String_Pool`) give equal strings equal
+// addresses, which `String_Lookup` makes use of.
+class String_Column {
+ private:
+  std::vector<const char*> strings;
+
+ public:
+  String_Column() {}
+
+  String_Column(std::initializer_list<const char*> list) : strings(list) {}
+
+  template <typename Source, typename = decltype(&String_Source<Source>::append)>
+  String_Column(const Source& source) {
+    String_Source<Source>::append(source, strings);
+  }
+
+  void reserve(const int n) { strings.reserve(n); }
+
+  void push_back(const char* s) { strings.push_back(s); }
+
+  int size() const { return strings.size(); }
+
+  const char* operator[](const int i) const { return strings[i]; }
+
+  const char* at(const int i) const {
+    if (i < 0 || i >= size()) stop("String index out of range");
+    return strings[i];
+  }
+};
+
+// Keeps one copy of every distinct string, playing the part of R's string cache for
+// input read outside of R
+class String_Pool {
+ private:
+  std::unordered_set<std::string> pool; // Elements never move so addresses are stable
+
+ public:
+  const char* intern(const std::string& s) { return pool.insert(s).first->c_str(); }
+
+  int size() const { return pool.size(); }
+};
+
+#endif
@@ -0,0 +1,81 @@
+#ifndef __STRING_LOOKUP_INCLUDED__
+#define __STRING_LOOKUP_INCLUDED__
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Memory_Usage.h"
+#include "String_Column.h"
+
+// Maps the strings of a `String_Column` to values without copying them. R keeps a single
+// copy of every distinct string (as does `String_Pool`) so lookups from other columns
+// can hash the string's address instead of its contents. Strings that miss on address
+// (the same bytes kept as separate strings, e.g. with different encoding marks, or
+// strings from another source) fall back to a content keyed map that is only built the
+// first time it is needed. Contents are compared byte for byte, so the same text in two
+// encodings (latin1 and UTF-8, say) doesn't match; ids need converting to one encoding
+// before they come in.
+template <typename Value>
+class String_Lookup {
+ private:
+  std::unordered_map<const char*, Value> by_address;
+  std::vector<std::pair<const char*, Value>> entries; // Insertion order, for the fallback map
+  std::unordered_map<std::string, Value> by_content;
+  bool content_built = false;
+
+  void build_content_map() {
+    by_content.reserve(entries.size());
+    for (const auto& entry : entries) by_content.emplace(entry.first, entry.second);
+    content_built = true;
+  }
+
+ public:
+  String_Lookup() {}
+
+  explicit String_Lookup(const int expected_size) {
+    by_address.reserve(expected_size);
+    entries.reserve(expected_size);
+  }
+
+  // The first value for a given string is kept, like `std::unordered_map::emplace()`
+  void insert(const char* key, const Value& value) {
+    if (by_address.emplace(key, value).second) {
+      entries.emplace_back(key, value);
+      if (content_built) by_content.emplace(key, value);
+    }
+  }
+
+  // Only checks for the exact string address, so never changes the lookup and is safe
+  // to call from several threads at once. Returns nullptr on a miss.
+  const Value* find_by_address(const char* key) const {
+    const auto address_it = by_address.find(key);
+    return address_it == by_address.end() ? nullptr : &address_it->second;
+  }
+
+  // Returns nullptr if the string isn't in the lookup
+  const Value* find(const char* key) {
+    const auto address_it = by_address.find(key);
+    if (address_it != by_address.end()) return &address_it->second;
+
+    return find(std::string(key));
+  }
+
+  const Value* find(const std::string& key) {
+    if (!content_built) build_content_map();
+
+    const auto content_it = by_content.find(key);
+    return content_it == by_content.end() ? nullptr : &content_it->second;
+  }
+
+  int size() const { return entries.size(); }
+
+  Memory_Usage memory_usage() const {
+    Memory_Usage usage;
+    add_map(usage, "by_address", by_address);
+    usage.add_vector("entries", entries);
+    add_map(usage, "by_content", by_content);
+    return usage;
+  }
+};
+
+#endif
@@ -0,0 +1,119 @@
+#ifndef __SWEEP_SCHEDULER_INCLUDED__
+#define __SWEEP_SCHEDULER_INCLUDED__
+
+#include "Node_Container.h"
+
+enum class Sweep_Order {
+  fixed,   // Order nodes sit in their container (best for memory locality)
+  random,  // New random permutation every sweep
+  degree,  // Highest degree nodes first
+  active   // Only nodes whose neighborhood changed last sweep, most recent first
+};
+
+inline Sweep_Order sweep_order_from_name(const string& order_name) {
+  if (order_name == "fixed") return Sweep_Order::fixed;
+  if (order_name == "random") return Sweep_Order::random;
+  if (order_name == "degree") return Sweep_Order::degree;
+  if (order_name == "active") return Sweep_Order::active;
+  stop("Sweep order must be one of fixed, random, degree, or active");
+}
+
+// Decides which nodes get visited in each sweep, and in what order. Nodes without any
+// edges are left out entirely as there's nothing to move them with. All orders reuse the
+// same buffers from sweep to sweep.
+//
+// With active scheduling, a node is only visited if it or one of its neighbors moved in
+// the previous sweep, so converged parts of the network get skipped. To keep every node
+// reachable, every `full_sweep_interval`th sweep visits every node. A sweep after one
+// with no moves visits nothing, so a converged chain only pays for the full sweeps.
+class Sweep_Scheduler {
+ private:
+  Sweep_Order order;
+  int full_sweep_interval;
+  int sweep_i = 0;
+  Node_Ptrs all_nodes;           // Every node with edges, in base order for schedule
+  Node_Ptrs active_nodes;        // Nodes marked active for the next sweep
+  Node_Ptrs visit_order;         // What was handed out for the current sweep
+  std::vector<char> is_active;   // Indexed by node index
+
+  void mark_active(Node* node) {
+    if (is_active[node->index]) return;
+    is_active[node->index] = true;
+    active_nodes.push_back(node);
+  }
+
+ public:
+  Sweep_Scheduler(const Node_Container& nodes,
+                  const Sweep_Order sweep_order = Sweep_Order::fixed,
+                  const int full_sweep_every = 10)
+      : order(sweep_order),
+        full_sweep_interval(std::max(1, full_sweep_every)),
+        is_active(nodes.size(), false) {
+    all_nodes.reserve(nodes.size());
+
+    for (const auto& nodes_of_type : nodes.nodes) {
+      for (const auto& node : nodes_of_type) {
+        if (node->get_degree() > 0) all_nodes.push_back(node.get());
+      }
+    }
+
+    // Degrees of nodes don't change so this only needs doing once
+    if (order == Sweep_Order::degree) {
+      std::stable_sort(all_nodes.begin(), all_nodes.end(), [](const Node* a, const Node* b) {
+        return a->get_degree() > b->get_degree();
+      });
+    }
+
+    visit_order.reserve(all_nodes.size());
+    active_nodes.reserve(all_nodes.size());
+  }
+
+  // Nodes to visit in the next sweep
+  const Node_Ptrs& next_sweep(Random_Engine& random_engine) {
+    const bool full_sweep = order != Sweep_Order::active ||
+                            sweep_i % full_sweep_interval == 0;
+    sweep_i++;
+
+    if (full_sweep) {
+      visit_order.assign(all_nodes.begin(), all_nodes.end());
+    } else {
+      // Most recently disturbed neighborhoods go first
+      visit_order.assign(active_nodes.rbegin(), active_nodes.rend());
+    }
+
+    if (order == Sweep_Order::random) {
+      std::shuffle(visit_order.begin(), visit_order.end(), random_engine);
+    }
+
+    // Start collecting the active set for the following sweep
+    for (const auto& node : active_nodes) is_active[node->index] = false;
+    active_nodes.clear();
+
+    return visit_order;
+  }
+
+  // Let the scheduler know a node changed blocks, making its neighborhood active
+  void node_moved(Node* node) {
+    if (order != Sweep_Order::active) return;
+
+    mark_active(node);
+    for (const auto& neighbors_of_type : node->get_edges()) {
+      for (const auto& neighbor : neighbors_of_type) {
+        if (neighbor->get_degree() > 0) mark_active(neighbor);
+      }
+    }
+  }
+
+  Sweep_Order get_order() const { return order; }
+
+  Memory_Usage memory_usage() const {
+    Memory_Usage usage;
+    usage.add_vector("node_lists", all_nodes);
+    usage.add_vector("node_lists", active_nodes);
+    usage.add_vector("node_lists", visit_order);
+    usage.add_vector("active_flags", is_active);
+    return usage;
+  }
+};
+
+#endif
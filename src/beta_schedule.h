@@ -0,0 +1,49 @@
+#ifndef __BETA_SCHEDULE_INCLUDED__
+#define __BETA_SCHEDULE_INCLUDED__
+
+#include <cmath>
+#include "error_helpers.h"
+
+using string = std::string;
+
+enum class Schedule_Type { constant, linear, geometric };
+
+// Inverse temperature (beta) to run each sweep of a fit at. A constant beta of
+// 1 samples the posterior; ramping beta up over the run anneals the chain.
+struct Beta_Schedule {
+  Schedule_Type type = Schedule_Type::constant;
+  double beta_start = 1.0;
+  double beta_end = 1.0;
+
+  Beta_Schedule() {}
+
+  Beta_Schedule(const Schedule_Type t, const double start, const double end)
+      : type(t), beta_start(start), beta_end(end) {
+    if (type == Schedule_Type::geometric && (beta_start <= 0 || beta_end <= 0))
+      stop("Geometric beta schedules need positive start and end betas");
+  }
+
+  Beta_Schedule(const string& type_name, const double start, const double end)
+      : Beta_Schedule(schedule_type_from_name(type_name), start, end) {}
+
+  static Schedule_Type schedule_type_from_name(const string& type_name) {
+    if (type_name == "constant") return Schedule_Type::constant;
+    if (type_name == "linear") return Schedule_Type::linear;
+    if (type_name == "geometric") return Schedule_Type::geometric;
+    stop("Beta schedule must be one of constant, linear, or geometric");
+  }
+
+  // Beta for sweep `sweep_i` (zero based) of a run of `num_sweeps` sweeps
+  double beta_at(const int sweep_i, const int num_sweeps) const {
+    if (type == Schedule_Type::constant) return beta_start;
+
+    // Proportion of the way through the run, ending exactly on `beta_end`
+    const double progress = num_sweeps > 1 ? double(sweep_i) / (num_sweeps - 1) : 1.0;
+
+    return type == Schedule_Type::linear
+               ? beta_start + (beta_end - beta_start) * progress
+               : beta_start * std::pow(beta_end / beta_start, progress);
+  }
+};
+
+#endif
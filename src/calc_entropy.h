@@ -0,0 +1,27 @@
+#pragma once
+// Calculates the entropy (description length up to a constant) of the SBM for
+// the current block assignments.
+// Uses formula -1/2 sum over all blocks r, s of e_rs * log(e_rs / (e_r * e_s))
+// Where e_rs : number of edges between blocks r and s (doubled when r = s)
+//       e_r  : total number of edges for block r (aka its degree)
+// The 1/2 is there because every pair of blocks gets visited from both sides.
+// This is the same quantity that `get_move_results()` reports deltas of.
+
+#include "Node_Container.h"
+#include "entropy_kernels.h"
+
+inline double calc_entropy(Node_Container& blocks) {
+  Entropy_Terms terms;
+
+  for (const auto& blocks_of_type : blocks.nodes) {
+    for (const auto& block : blocks_of_type) {
+      const double block_degree = block->get_degree();
+
+      blocks.get_edge_counts().for_each_in_row(block.get(), [&](Node* other, const int count) {
+        terms.add(count, block_degree, other->get_degree(), -0.5);
+      });
+    }
+  }
+
+  return sum_entropy_terms(terms);
+}
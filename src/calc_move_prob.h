@@ -10,14 +10,13 @@
 
 #include "Node_Container.h"
 
-using Node_Edge_Counts = std::map<Node*, int>;
 using Edge_Count_Pair = std::pair<Node*, int>;
 
-double calc_move_prob(const Node_Edge_Counts& node_to_blocks,
-                      Node* block_moved_to,
-                      const double node_degree,
-                      const double eps,
-                      const double epsB) {
+inline double calc_move_prob(const Node_Edge_Counts& node_to_blocks,
+                             Node* block_moved_to,
+                             const double node_degree,
+                             const double eps,
+                             const double epsB) {
 
   Node_Edge_Counts block_counts = block_moved_to->get_block_edge_counts();
 
@@ -0,0 +1,17 @@
+#ifndef __ERROR_HELPERS_INCLUDED__
+#define __ERROR_HELPERS_INCLUDED__
+
+#include <stdexcept>
+#include <string>
+
+// Errors raised by the model code. Rcpp turns a std::exception thrown out of an
+// exported function into an R error with the same message, so the core can raise
+// errors without knowing whether it's running inside R.
+class Sbm_Error : public std::runtime_error {
+ public:
+  using std::runtime_error::runtime_error;
+};
+
+[[noreturn]] inline void stop(const std::string& message) { throw Sbm_Error(message); }
+
+#endif
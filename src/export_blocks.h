@@ -0,0 +1,102 @@
+#ifndef __EXPORT_BLOCKS_INCLUDED__
+#define __EXPORT_BLOCKS_INCLUDED__
+
+#include "Node_Container.h"
+
+// Writers that copy a model's blocks straight into preallocated output, e.g. the
+// storage of an R vector, in a single pass over the nodes or block edge counts. Outputs
+// are anything indexable like a random access iterator (`int*`, a vector's `begin()`)
+// and must already hold as many elements as described.
+
+// One past the highest block index, so every block has a row when outputs are indexed
+// by block
+inline int block_index_span(const Node_Container& blocks) {
+  int span = 0;
+  for (const auto& blocks_of_type : blocks.nodes) {
+    for (const auto& block : blocks_of_type) span = std::max(span, block->index + 1);
+  }
+  return span;
+}
+
+// Number of block pairs r, s with e_rs above zero, counting r, s and s, r separately
+inline int num_block_edge_entries(const Node_Container& blocks) {
+  const Block_Edge_Counts& edge_counts = blocks.get_edge_counts();
+  int num_entries = 0;
+  for (const auto& blocks_of_type : blocks.nodes) {
+    for (const auto& block : blocks_of_type) {
+      edge_counts.for_each_in_row(block.get(), [&](const Node*, int) { num_entries++; });
+    }
+  }
+  return num_entries;
+}
+
+// Block index of every node, at the node's index (input order). Needs `nodes.size()`
+template <typename Int_Out>
+void write_block_assignments(const Node_Container& nodes, Int_Out assignments) {
+  for (const auto& nodes_of_type : nodes.nodes) {
+    for (const auto& node : nodes_of_type) {
+      assignments[node->index] = node->get_parent()->index;
+    }
+  }
+}
+
+// Nonzero e_rs as triplets, block r's index in `rows`, s's in `cols` and the count in
+// `counts`, all plus `index_offset` (1 for R). Needs `num_block_edge_entries()`.
+template <typename Int_Out, typename Count_Out>
+void write_block_edge_triplets(const Node_Container& blocks,
+                               Int_Out rows,
+                               Int_Out cols,
+                               Count_Out counts,
+                               const int index_offset = 0) {
+  const Block_Edge_Counts& edge_counts = blocks.get_edge_counts();
+  int entry_i = 0;
+  for (const auto& blocks_of_type : blocks.nodes) {
+    for (const auto& block : blocks_of_type) {
+      const int row = block->index + index_offset;
+      edge_counts.for_each_in_row(block.get(), [&](const Node* s, const int e_rs) {
+        rows[entry_i] = row;
+        cols[entry_i] = s->index + index_offset;
+        counts[entry_i] = e_rs;
+        entry_i++;
+      });
+    }
+  }
+}
+
+// e_rs into a column major `num_rows` square matrix indexed by block index, which
+// needs `num_rows` of at least `block_index_span()`. Only nonzero entries are written,
+// so the matrix needs to start out zeroed.
+template <typename Count_Out>
+void write_block_edge_matrix(const Node_Container& blocks, const int num_rows, Count_Out matrix) {
+  const Block_Edge_Counts& edge_counts = blocks.get_edge_counts();
+  for (const auto& blocks_of_type : blocks.nodes) {
+    for (const auto& block : blocks_of_type) {
+      const int row = block->index;
+      edge_counts.for_each_in_row(block.get(), [&](const Node* s, const int e_rs) {
+        matrix[row + s->index * num_rows] = e_rs;
+      });
+    }
+  }
+}
+
+// One entry per block, in container order: its index, type index, number of nodes and
+// degree. Needs `blocks.size()`.
+template <typename Int_Out>
+void write_block_stats(const Node_Container& blocks,
+                       Int_Out indices,
+                       Int_Out types,
+                       Int_Out sizes,
+                       Int_Out degrees) {
+  int block_i = 0;
+  for (const auto& blocks_of_type : blocks.nodes) {
+    for (const auto& block : blocks_of_type) {
+      indices[block_i] = block->index;
+      types[block_i] = block->type_index;
+      sizes[block_i] = block->children.size();
+      degrees[block_i] = block->get_degree();
+      block_i++;
+    }
+  }
+}
+
+#endif
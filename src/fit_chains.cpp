@@ -0,0 +1,99 @@
+#include "rcpp_adapter.h"
+#include "reorder_nodes.h"
+#include "run_chains.h"
+
+using namespace Rcpp;
+
+// Fits multiple independent chains of an SBM to a network, ingesting the
+// network just once. Returns every chain's entropy trace (one column per
+// chain), every chain's final block assignments (rows in order of `nodes_id`)
+// and the assignments of the chain that ended with the lowest entropy.
+// `beta_schedule` is one of "constant", "linear" or "geometric" and ramps the
+// inverse temperature from `beta_start` to `beta_end` over the sweeps.
+// `sweep_order` is one of "fixed", "random", "degree" or "active" and sets
+// which nodes each sweep visits and in what order. `node_order` is one of
+// "input", "degree", "bfs" or "rcm" and lays the network out in memory so
+// connected nodes sit close together; it doesn't change the returned order.
+// `block_init` is one of "random", "label_propagation" or "signature" and picks
+// how each chain's starting blocks are chosen. `convergence_test` is one of
+// "none", "slope" or "geweke"; with a test each chain stops once its last
+// `convergence_window` sweeps look stationary to within `convergence_tolerance`.
+// Entropy rows after a chain stopped are NA, `sweeps_run` and `stop_reason` say
+// how far each chain went and why it stopped. With `eps_tune_sweeps` above 0 each
+// chain spends that many sweeps of burn-in tuning eps for each node type towards
+// `eps_target_acceptance` of its proposed moves being accepted, then keeps it fixed;
+// `eps` has the values each chain settled on (rows in order of `types_name`).
+// [[Rcpp::export]]
+List fit_chains(const CharacterVector nodes_id,
+                const CharacterVector nodes_type,
+                const CharacterVector types_name,
+                const IntegerVector types_count,
+                const CharacterVector edges_from,
+                const CharacterVector edges_to,
+                const int num_blocks,
+                const int num_sweeps,
+                const int num_chains = 8,
+                const int seed = 42,
+                const double eps = 0.1,
+                const int num_threads = 0,
+                const std::string beta_schedule = "constant",
+                const double beta_start = 1.0,
+                const double beta_end = 1.0,
+                const std::string sweep_order = "fixed",
+                const std::string node_order = "input",
+                const std::string block_init = "random",
+                const std::string convergence_test = "none",
+                const int convergence_window = 50,
+                const double convergence_tolerance = 1e-3,
+                const int eps_tune_sweeps = 0,
+                const double eps_target_acceptance = 0.2) {
+  auto nodes = Node_Container(nodes_id, nodes_type, types_name, types_count);
+  auto edges = Edge_Container(edges_from, edges_to, nodes_id, nodes, {}, {}, num_threads);
+  reorder_nodes(nodes, node_order_from_name(node_order));
+
+  const auto schedule = Beta_Schedule(beta_schedule, beta_start, beta_end);
+  const auto convergence = Convergence_Settings(convergence_test, convergence_window,
+                                                convergence_tolerance);
+  const auto eps_tuning = Eps_Tuning(eps_tune_sweeps, eps_target_acceptance);
+
+  const auto results = run_chains(nodes, edges, num_blocks, num_sweeps,
+                                  num_chains, seed, eps, num_threads, schedule,
+                                  sweep_order_from_name(sweep_order),
+                                  block_init_from_name(block_init), convergence,
+                                  eps_tuning);
+
+  NumericMatrix entropy_traces(num_sweeps + 1, num_chains);
+  std::fill(entropy_traces.begin(), entropy_traces.end(), NA_REAL);
+  IntegerMatrix assignments(nodes.size(), num_chains);
+  NumericVector final_entropy(num_chains);
+  IntegerVector sweeps_run(num_chains);
+  CharacterVector stop_reason(num_chains);
+  NumericMatrix eps_by_type(nodes.num_types(), num_chains);
+
+  for (int chain_i = 0; chain_i < num_chains; chain_i++) {
+    const Chain_Results& chain = results.chains[chain_i];
+
+    std::copy(chain.entropy_trace.begin(), chain.entropy_trace.end(),
+              entropy_traces.begin() + chain_i * entropy_traces.nrow());
+    std::copy(chain.block_assignments.begin(), chain.block_assignments.end(),
+              assignments.begin() + chain_i * assignments.nrow());
+    final_entropy[chain_i] = chain.entropy();
+    sweeps_run[chain_i] = chain.num_sweeps();
+    stop_reason[chain_i] = stop_reason_name(chain.stop_reason);
+    std::copy(chain.eps_by_type.begin(), chain.eps_by_type.end(),
+              eps_by_type.begin() + chain_i * eps_by_type.nrow());
+  }
+
+  const Chain_Results& best = results.chains[results.best_chain];
+
+  return List::create(
+      _["entropy"] = entropy_traces,
+      _["assignments"] = assignments,
+      _["final_entropy"] = final_entropy,
+      _["sweeps_run"] = sweeps_run,
+      _["stop_reason"] = stop_reason,
+      _["eps"] = eps_by_type,
+      _["best_chain"] = results.best_chain + 1,
+      _["best_assignments"] = IntegerVector(best.block_assignments.begin(),
+                                            best.block_assignments.end()));
+}
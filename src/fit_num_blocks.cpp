@@ -0,0 +1,76 @@
+#include "rcpp_adapter.h"
+#include "reorder_nodes.h"
+#include "select_num_blocks.h"
+
+using namespace Rcpp;
+
+// Fits the network with a range of block counts, from `min_blocks` to `max_blocks`
+// blocks per type, searching for the one with the smallest description length (see
+// `select_num_blocks()`). Each round fits up to `candidates_per_round` block counts
+// on separate threads, warm started from earlier fits by merging or splitting their
+// blocks. Returns one row per fit made in `fits`, the best number of blocks and the
+// best fit's block assignments (in order of `nodes_id`, numbered as in
+// `fit_chains()`). `sweep_order`, `node_order` and `block_init` are as in
+// `fit_chains()`, `block_init` only applies to the first round.
+// [[Rcpp::export]]
+List fit_num_blocks(const CharacterVector nodes_id,
+                    const CharacterVector nodes_type,
+                    const CharacterVector types_name,
+                    const IntegerVector types_count,
+                    const CharacterVector edges_from,
+                    const CharacterVector edges_to,
+                    const int min_blocks,
+                    const int max_blocks,
+                    const int num_sweeps,
+                    const int seed = 42,
+                    const double eps = 0.1,
+                    const int num_threads = 0,
+                    const int candidates_per_round = 4,
+                    const std::string sweep_order = "fixed",
+                    const std::string node_order = "input",
+                    const std::string block_init = "random") {
+  auto nodes = Node_Container(nodes_id, nodes_type, types_name, types_count);
+  auto edges = Edge_Container(edges_from, edges_to, nodes_id, nodes, {}, {}, num_threads);
+  reorder_nodes(nodes, node_order_from_name(node_order));
+
+  const auto selection = select_num_blocks(nodes, edges, min_blocks, max_blocks, num_sweeps,
+                                           seed, eps, num_threads, candidates_per_round,
+                                           sweep_order_from_name(sweep_order),
+                                           block_init_from_name(block_init));
+
+  const int num_fits = selection.fits.size();
+  IntegerVector num_blocks(num_fits);
+  IntegerVector warm_start_from(num_fits);
+  IntegerVector round(num_fits);
+  NumericVector entropy(num_fits);
+  NumericVector description_length(num_fits);
+
+  for (int fit_i = 0; fit_i < num_fits; fit_i++) {
+    const Block_Count_Fit& fit = selection.fits[fit_i];
+    num_blocks[fit_i] = fit.num_blocks;
+    warm_start_from[fit_i] = fit.warm_start_from;
+    round[fit_i] = fit.round + 1;
+    entropy[fit_i] = fit.entropy;
+    description_length[fit_i] = fit.description_length;
+  }
+
+  // Blocks are numbered type by type, as a freshly built block container numbers them
+  const Block_Count_Fit& best = selection.fits[selection.best_fit];
+  IntegerVector best_assignments(nodes.size());
+  for (const auto& nodes_of_type : nodes.nodes) {
+    for (const auto& node : nodes_of_type) {
+      best_assignments[node->index] =
+          node->type_index * best.num_blocks + best.block_positions[node->index];
+    }
+  }
+
+  return List::create(
+      _["fits"] = List::create(
+          _["num_blocks"] = num_blocks,
+          _["warm_start_from"] = warm_start_from,
+          _["round"] = round,
+          _["entropy"] = entropy,
+          _["description_length"] = description_length),
+      _["best_num_blocks"] = best.num_blocks,
+      _["best_assignments"] = best_assignments);
+}
@@ -0,0 +1,44 @@
+#include "rcpp_adapter.h"
+#include "Streaming_SBM.h"
+#include "run_chains.h"
+
+using namespace Rcpp;
+
+// Writes a network's adjacency to `path` for `fit_out_of_core()`. Only needs to
+// happen once per network; the file can be reused across fits and sessions.
+// [[Rcpp::export]]
+void write_adjacency(const std::string path,
+                     const CharacterVector nodes_id,
+                     const CharacterVector nodes_type,
+                     const CharacterVector types_name,
+                     const CharacterVector edges_from,
+                     const CharacterVector edges_to) {
+  write_adjacency_file(path, nodes_id, nodes_type, types_name, edges_from, edges_to);
+}
+
+// Fits a single chain against an adjacency file written by `write_adjacency()`,
+// leaving the edges on disk. Returns the entropy at the start and after every sweep
+// and the final block of each node (in order of the `nodes_id` the file was written
+// from). Blocks of the second type are numbered after those of the first and so on.
+// [[Rcpp::export]]
+List fit_out_of_core(const std::string path,
+                     const int num_blocks,
+                     const int num_sweeps,
+                     const int seed = 42,
+                     const double eps = 0.1,
+                     const double beta = 1.0) {
+  const Mapped_Adjacency adjacency(path);
+  Streaming_SBM sbm(adjacency, num_blocks, chain_random_engine(seed, 0));
+
+  NumericVector entropy_trace(num_sweeps + 1);
+  entropy_trace[0] = sbm.entropy();
+  for (int i = 0; i < num_sweeps; i++) {
+    entropy_trace[i + 1] = entropy_trace[i] + sbm.mcmc_sweep(eps, beta).entropy_delta;
+  }
+
+  const Int_Vec assignments = sbm.block_assignments();
+
+  return List::create(
+      _["entropy"] = entropy_trace,
+      _["assignments"] = IntegerVector(assignments.begin(), assignments.end()));
+}
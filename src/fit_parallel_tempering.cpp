@@ -0,0 +1,56 @@
+#include "rcpp_adapter.h"
+#include "parallel_tempering.h"
+#include "reorder_nodes.h"
+
+using namespace Rcpp;
+
+// Fits an SBM with parallel tempering: one replica per inverse temperature in
+// `betas`, exchanging states between neighboring temperatures every
+// `swap_interval` sweeps. Returns the entropy trace of each temperature (one
+// column per beta, one row per exchange round), the final assignments of the
+// replica at each temperature (rows in order of `nodes_id`) and the rate at
+// which each neighboring pair of temperatures swapped. `node_order` lays the
+// network out in memory, as in `fit_chains()`.
+// [[Rcpp::export]]
+List fit_parallel_tempering(const CharacterVector nodes_id,
+                            const CharacterVector nodes_type,
+                            const CharacterVector types_name,
+                            const IntegerVector types_count,
+                            const CharacterVector edges_from,
+                            const CharacterVector edges_to,
+                            const int num_blocks,
+                            const int num_sweeps,
+                            const NumericVector betas,
+                            const int swap_interval = 10,
+                            const int seed = 42,
+                            const double eps = 0.1,
+                            const int num_threads = 0,
+                            const std::string node_order = "input") {
+  auto nodes = Node_Container(nodes_id, nodes_type, types_name, types_count);
+  auto edges = Edge_Container(edges_from, edges_to, nodes_id, nodes, {}, {}, num_threads);
+  reorder_nodes(nodes, node_order_from_name(node_order));
+
+  const auto results = run_parallel_tempering(nodes, edges, num_blocks, num_sweeps,
+                                              Double_Vec(betas.begin(), betas.end()),
+                                              swap_interval, seed, eps, num_threads);
+
+  const int num_betas = betas.size();
+  const int num_rounds = results.entropy_traces[0].size();
+
+  NumericMatrix entropy_traces(num_rounds, num_betas);
+  IntegerMatrix assignments(nodes.size(), num_betas);
+
+  for (int beta_i = 0; beta_i < num_betas; beta_i++) {
+    std::copy(results.entropy_traces[beta_i].begin(), results.entropy_traces[beta_i].end(),
+              entropy_traces.begin() + beta_i * num_rounds);
+    std::copy(results.block_assignments[beta_i].begin(), results.block_assignments[beta_i].end(),
+              assignments.begin() + beta_i * assignments.nrow());
+  }
+
+  return List::create(
+      _["betas"] = betas,
+      _["entropy"] = entropy_traces,
+      _["assignments"] = assignments,
+      _["swap_acceptance"] = NumericVector(results.swap_acceptance.begin(),
+                                           results.swap_acceptance.end()));
+}
@@ -3,17 +3,16 @@
 // calculates both the entropy delta of the SBM before and after the proposed move and
 // the ratio of the probabilities of moving to the proposed block before the move and
 // moving back to the original block after the move.
-// #include "calc_edge_entropy.h"
-#include "Edge_Container.h"
+//
+// Everything that only depends on the node and its current block (its neighbor-block
+// histogram, its block's row of edge counts, epsB) is gathered once by a `Move_Evaluator`,
+// so scoring the same node against several candidate blocks only costs a pass over each
+// candidate's own row. Post-move counts and degrees are worked out directly rather than
+// by temporarily moving the node, so evaluating a move never touches the blocks.
+#include "Move_Context.h"
+#include "Neighbor_Histograms.h"
 #include "calc_move_prob.h"
-#include "swap_blocks.h"
-
-using Edge = Ordered_Pair<Node*>;
-using Edge_Map = std::map<Edge, int>;
-using Edge_Map_Pair = std::pair<Edge, int>;
-
-using Node_Edge_Counts = std::map<Node*, int>;
-using Edge_Count = std::pair<Node*, int>;
+#include "entropy_kernels.h"
 
 struct Move_Results {
   double entropy_delta = 0.0;
@@ -23,115 +22,201 @@ struct Move_Results {
     prob_ratio(p) {}
 };
 
-void sum_edge_counts(Edge_Map& pair_counts,
-                     Node* this_block,
-                     const Node* to_ignore = nullptr){
-
-  auto add_edge = [&](const Edge_Count& block_count){
-    if (block_count.first != to_ignore)
-      pair_counts[Edge(this_block, block_count.first)] += block_count.second;
-  };
-
-  Node_Edge_Counts edges_cts = this_block->get_block_edge_counts();
-
-  std::for_each(edges_cts.begin(), edges_cts.end(), add_edge);
+// Adds the (negative) entropy contribution of the edges between two blocks to a set of
+// terms, with `sign` of 1 for pre-move and -1 for post-move pairs.
+// Self edge contributions come in with their edge counts doubled (because they are
+// half edges) and also need to have their total contribution divided by two
+// because they are getting counted twice as "frequently" as the off-diagonal pairs
+inline void add_edge_entropy_term(Entropy_Terms& terms,
+                                  const double n_edges,
+                                  const double g1_degree,
+                                  const double g2_degree,
+                                  const double sign,
+                                  const bool same_block = false) {
+  terms.add(n_edges, g1_degree, g2_degree, same_block ? sign / 2.0 : sign);
 }
 
-Move_Results get_move_results(Node* node,
-                              Node* new_block,
-                              const Node_Container& nodes,
-                              Node_Container& blocks,
-                              const Edge_Container& edges,
-                              const double eps = 0.1){
-  Node* old_block = node->get_parent();
+class Move_Evaluator {
+ private:
+  Node* node;
+  Node* old_block;
+  double eps;
+  double epsB;
+  double node_degree;
+  const Block_Edge_Counts& block_counts; // Edges between each pair of blocks
+  Block_Histogram built_histogram;   // Only filled if no histogram is handed over
+  const Block_Histogram& node_to_blocks; // Edges from node to each block
+  double old_degree;
+  double old_degree_post;
+  int node_self_edges;               // Times node shows up in its own edges
+  double old_row_delta = 0.0;        // Entropy change of old block's row
+  Entropy_Terms terms;               // Scratch space for candidate's terms
+
+  int count_for_block(const Node* block) const { return node_to_blocks.count_for(block); }
+
+  // Builds the node's histogram itself when not given one
+  Move_Evaluator(Node* node_to_move, const Move_Context& context, const Block_Histogram* histogram)
+      : node(node_to_move),
+        old_block(node_to_move->get_parent()),
+        eps(context.eps),
+        epsB(context.epsB),
+        node_degree(node_to_move->get_degree()),
+        block_counts(*context.block_counts),
+        built_histogram(histogram == nullptr ? Block_Histogram(node_to_move) : Block_Histogram()),
+        node_to_blocks(histogram == nullptr ? built_histogram : *histogram),
+        old_degree(old_block->get_degree()),
+        old_degree_post(old_degree - node_degree),
+        node_self_edges(node_to_blocks.self_edges) {
+
+    // The old block's row is the same whatever block the node moves to, apart from the
+    // entry for the new block itself, which gets backed out in `evaluate()`
+    block_counts.for_each_in_row(old_block, [&](Node* block, const int count) {
+      const bool self_pair = block == old_block;
+      const int node_count = self_pair ? 2 * count_for_block(block) - node_self_edges
+                                       : count_for_block(block);
+
+      add_edge_entropy_term(terms, count, old_degree,
+                            self_pair ? old_degree : block->get_degree(), 1, self_pair);
+      add_edge_entropy_term(terms, count - node_count, old_degree_post,
+                            self_pair ? old_degree_post : block->get_degree(), -1, self_pair);
+    });
+
+    old_row_delta = sum_entropy_terms(terms);
+  }
 
-  // No need to go on if we're "swapping" to the same group
-  if(new_block == old_block) return Move_Results(0, 1);
-
-  const double node_degree = node->get_degree();
-  const Int_Vec node_neighbor_types = edges.neighbor_types_for_node(node->type_index);
-  const int n_possible_neighbors = std::accumulate(node_neighbor_types.begin(),
-                                                   node_neighbor_types.end(),
-                                                   0,
-                                                   [&blocks](int n, const int type) {
-                                                     return n + blocks.size_of_type(type);
-                                                   });
-
-  const double epsB = eps * double(n_possible_neighbors);
-
-  Node_Edge_Counts node_to_blocks = node->get_block_edge_counts();
-
-  Edge_Map block_pair_counts;
-  sum_edge_counts(block_pair_counts, old_block, new_block);
-  sum_edge_counts(block_pair_counts, new_block);
-  bool post_move = false;
-
-  auto calc_edge_entropy_part = [&post_move, &old_block, &new_block, &node_degree]
-                                (double ent_sum, const Edge_Map_Pair& edge_count){
-    const double n_edges = edge_count.second;
-    if(n_edges == 0.0) return ent_sum;
-
-    // Self edge contributions need their edge counts doubled (because they are half edges)
-    // and also need to have their total contribution divided by two
-    // because they are getting counted twice as "frequently as the off-diagonal pairs
-    const Edge& edge = edge_count.first;
-    const double edge_scalar = edge.is_matching() ? 2.0: 1.0;
-
-    const Node* g1 = edge.first();
-    const Node* g2 = edge.second();
-
-    double g1_degree = g1->get_degree();
-    double g2_degree = g2->get_degree();
-
-    if(post_move){
-      if (g1 == old_block) {
-        g1_degree -= node_degree;
-      } else
-      if (g1 == new_block) {
-        g1_degree += node_degree;
-      }
-
-      if (g2 == old_block) {
-        g2_degree -= node_degree;
-      } else
-      if (g2 == new_block) {
-        g2_degree += node_degree;
-      }
+ public:
+  Move_Evaluator(const Move_Evaluator& copied) = delete;
+  Move_Evaluator& operator=(const Move_Evaluator& copied) = delete;
+
+  Move_Evaluator(Node* node_to_move, const Move_Context& context)
+      : Move_Evaluator(node_to_move, context, nullptr) {}
+
+  // `histogram` is the node's current block histogram, e.g. from `Neighbor_Histograms`
+  Move_Evaluator(Node* node_to_move, const Move_Context& context, const Block_Histogram& histogram)
+      : Move_Evaluator(node_to_move, context, &histogram) {}
+
+  Move_Evaluator(Node* node_to_move,
+                 const Node_Container& blocks,
+                 const Edge_Container& edges,
+                 const double eps_value = 0.1)
+      : Move_Evaluator(node_to_move,
+                       Move_Context(node_to_move->type_index, blocks, edges, eps_value)) {}
+
+  // Not const as each candidate's terms go in the evaluator's scratch space, so threads
+  // scoring moves for the same node each need their own evaluator
+  Move_Results evaluate(Node* new_block) {
+    // No need to go on if we're "swapping" to the same group
+    if (new_block == old_block) return Move_Results(0, 1);
+
+    const double new_degree = new_block->get_degree();
+    const double new_degree_post = new_degree + node_degree;
+
+    const int node_to_old = count_for_block(old_block);
+    const int node_to_new = count_for_block(new_block);
+
+    auto degree_post = [&](Node* block) -> double {
+      return block == old_block ? old_degree_post
+           : block == new_block ? new_degree_post
+           : block->get_degree();
+    };
+
+    // Old block's row minus the pair with the new block, that's in the new block's row
+    terms.clear();
+
+    const int old_to_new = block_counts.get(old_block, new_block);
+    add_edge_entropy_term(terms, old_to_new, old_degree, new_degree, -1);
+    add_edge_entropy_term(terms, old_to_new - node_to_new, old_degree_post, new_degree, 1);
+
+    // New block's row gains the node's edges (its self edges included). The old-new pair
+    // loses the edges from the node to the new block and gains the edges from the node to
+    // the rest of the old block
+    auto new_row_post_count = [&](Node* block, const int count) {
+      const int node_count = count_for_block(block);
+
+      return block == new_block ? count + 2 * node_count + node_self_edges
+           : block == old_block ? count + node_count - node_self_edges - node_to_new
+           : count + node_count;
+    };
+
+    block_counts.for_each_in_row(new_block, [&](Node* block, const int count) {
+      const bool self_pair = block == new_block;
+
+      add_edge_entropy_term(terms, count, new_degree,
+                            self_pair ? new_degree : block->get_degree(), 1, self_pair);
+      add_edge_entropy_term(terms, new_row_post_count(block, count),
+                            new_degree_post, degree_post(block), -1, self_pair);
+    });
+
+    // Blocks the node connects to that the new block didn't before the move
+    for (const auto& node_count : node_to_blocks) {
+      Node* block = node_count.first;
+      if (block_counts.get(new_block, block) != 0) continue;
+
+      add_edge_entropy_term(terms, new_row_post_count(block, 0), new_degree_post,
+                            degree_post(block), -1, block == new_block);
     }
 
-    return ent_sum + n_edges * std::log(n_edges/(g1_degree*g2_degree)) / edge_scalar;;
-  };
-
-  const double pre_move_ent = std::accumulate(block_pair_counts.begin(),
-                                              block_pair_counts.end(),
-                                              0.0,
-                                              calc_edge_entropy_part);
+    // A node with self edges moving to a block it has no other ties to
+    if (node_self_edges > 0 && node_to_new == 0 && block_counts.get(new_block, new_block) == 0) {
+      add_edge_entropy_term(terms, node_self_edges, new_degree_post, new_degree_post, -1, true);
+    }
 
-  // Update edge counts
-  for (const auto& block_count : node_to_blocks) {
-    // subtract contributions for when node was in old block
-    block_pair_counts[Edge(old_block, block_count.first)] -= block_count.second * (block_count.first == old_block ? 2 : 1);
+    // Probability of moving to the new block and of moving back once there. After the
+    // move the old block loses the node's edges and the edges its other children had to
+    // the node now point at the new block
+    const int node_to_old_others = node_to_old - node_self_edges;
+    double prob_move_to_new = 0.0;
+    double prob_return_to_old = 0.0;
+
+    for (const auto& node_count : node_to_blocks) {
+      Node* block = node_count.first;
+      const double prop_of_edges = node_count.second / node_degree;
+
+      const int old_count_post = block_counts.get(old_block, block) - node_count.second
+                               - (block == old_block ? node_to_old_others : 0)
+                               + (block == new_block ? node_to_old_others : 0);
+
+      prob_move_to_new += prop_of_edges * (block_counts.get(new_block, block) + eps) /
+                                          (block->get_degree()                + epsB);
+      prob_return_to_old += prop_of_edges * (old_count_post     + eps) /
+                                            (degree_post(block) + epsB);
+    }
 
-    // add edge to new blocks edge counts
-    block_pair_counts[Edge(new_block, block_count.first)] += block_count.second * (block_count.first == new_block ? 2 : 1);
+    return Move_Results(old_row_delta + sum_entropy_terms(terms),
+                        prob_return_to_old / prob_move_to_new);
   }
+};
 
-  post_move = true;
-  const double post_move_ent = std::accumulate(block_pair_counts.begin(),
-                                               block_pair_counts.end(),
-                                               0.0,
-                                               calc_edge_entropy_part);
-
+inline Move_Results get_move_results(Node* node,
+                                     Node* new_block,
+                                     const Node_Container& /* nodes */,
+                                     Node_Container& blocks,
+                                     const Edge_Container& edges,
+                                     const double eps = 0.1){
+  // No need to go on if we're "swapping" to the same group
+  if(new_block == node->get_parent()) return Move_Results(0, 1);
 
-  const double prob_move_to_new = calc_move_prob(node_to_blocks, new_block, node_degree, eps, epsB);
-  // Move node to proposed block
-  swap_block(node, new_block, blocks, false);
-  const double prob_return_to_old = calc_move_prob(node_to_blocks, old_block, node_degree, eps, epsB);
+  return Move_Evaluator(node, blocks, edges, eps).evaluate(new_block);
+}
 
-  // Return node to original block
-  swap_block(node, old_block, blocks, false);
+// Scores moving a node to each of a set of candidate blocks, sharing all the work that
+// only depends on the node between them. Results are in the same order as `new_blocks`.
+// The network's nodes aren't needed, they're only taken to match the single block
+// version.
+inline std::vector<Move_Results> get_move_results(Node* node,
+                                                  const Node_Ptrs& new_blocks,
+                                                  const Node_Container& /* nodes */,
+                                                  Node_Container& blocks,
+                                                  const Edge_Container& edges,
+                                                  const double eps = 0.1){
+  Move_Evaluator evaluator(node, blocks, edges, eps);
+
+  std::vector<Move_Results> results;
+  results.reserve(new_blocks.size());
+
+  for (const auto& new_block : new_blocks) {
+    results.push_back(evaluator.evaluate(new_block));
+  }
 
-  return Move_Results(pre_move_ent - post_move_ent,
-                      prob_return_to_old / prob_move_to_new);
+  return results;
 }
-
@@ -0,0 +1,271 @@
+#ifndef __INITIAL_BLOCKS_INCLUDED__
+#define __INITIAL_BLOCKS_INCLUDED__
+
+#include <cstdint>
+#include <limits>
+#include <queue>
+#include <unordered_map>
+#include "Edge_Container.h"
+#include "parallel_helpers.h"
+
+// Ways of picking the blocks a chain starts from.
+// - random: Nodes of each type are shuffled and dealt out to the blocks in turn.
+// - label_propagation: Nodes take on the most common label of the nodes of their own
+//   type they are tied to (through a neighbor of another type in multipartite
+//   networks), then the resulting groups are packed into the blocks.
+// - signature: Nodes are grouped on a hash of their degree class and the smallest
+//   hashed neighbor, so nodes with overlapping neighborhoods tend to collide, then the
+//   groups are packed into the blocks.
+// Everything other than random is O(E) per pass and gives the same result whatever
+// the number of threads.
+enum class Block_Init { random, label_propagation, signature };
+
+inline Block_Init block_init_from_name(const string& init_name) {
+  if (init_name == "random") return Block_Init::random;
+  if (init_name == "label_propagation") return Block_Init::label_propagation;
+  if (init_name == "signature") return Block_Init::signature;
+
+  stop("Block initialization " + init_name +
+       " not recognized. Options are random, label_propagation or signature");
+}
+
+using Group_Keys = std::vector<std::uint64_t>;
+
+// Scrambles the bits of an integer (splitmix64 finalizer) so salted keys order randomly
+inline std::uint64_t mix_hash(std::uint64_t x) {
+  x += 0x9e3779b97f4a7c15ULL;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+// Runs `fn(node)` for every node, with the nodes split into one chunk per task
+template <typename Node_Fn>
+void for_each_node_in_parallel(const Node_Ptrs& all_nodes,
+                               const int num_threads,
+                               const Node_Fn& fn) {
+  const int chunk_size = 1024;
+  const int num_chunks = (all_nodes.size() + chunk_size - 1) / chunk_size;
+
+  run_in_parallel(num_chunks, num_threads, [&](const int chunk_i) {
+    const int end = std::min<int>(all_nodes.size(), (chunk_i + 1) * chunk_size);
+    for (int i = chunk_i * chunk_size; i < end; i++) fn(all_nodes[i]);
+  });
+}
+
+inline Node_Ptrs all_nodes_of(const Node_Container& nodes) {
+  Node_Ptrs all_nodes;
+  all_nodes.reserve(nodes.size());
+  for (const auto& nodes_of_type : nodes.nodes) {
+    for (const auto& node : nodes_of_type) all_nodes.push_back(node.get());
+  }
+  return all_nodes;
+}
+
+// Most frequent of a set of label counts. Ties go to `current` if it's among them,
+// otherwise to the label with the smallest salted hash. Returns -1 for no labels.
+inline int most_common_label(const std::unordered_map<int, int>& label_counts,
+                             const int current,
+                             const std::uint64_t salt) {
+  int best_label = -1;
+  int best_count = 0;
+
+  for (const auto& label_count : label_counts) {
+    const bool better =
+        label_count.second > best_count ||
+        (label_count.second == best_count &&
+         mix_hash(label_count.first ^ salt) < mix_hash(best_label ^ salt));
+
+    if (better) {
+      best_label = label_count.first;
+      best_count = label_count.second;
+    }
+  }
+
+  const auto current_count = label_counts.find(current);
+  if (current_count != label_counts.end() && current_count->second == best_count) {
+    return current;
+  }
+
+  return best_label;
+}
+
+// Synchronous label propagation: every node's new label comes from the previous
+// pass's labels so the order nodes are visited in doesn't matter. Labels only spread
+// between nodes of the same type. A neighbor of another type passes on the most common
+// label among its own neighbors of the node's type, which keeps each pass O(E).
+inline Group_Keys label_propagation_keys(const Node_Container& nodes,
+                                         Random_Engine& random_engine,
+                                         const int num_threads = 1,
+                                         const int max_passes = 20) {
+  const int n_types = nodes.num_types();
+  const std::uint64_t salt = random_engine();
+  const Node_Ptrs all_nodes = all_nodes_of(nodes);
+
+  Int_Vec labels(nodes.size());
+  for (const Node* node : all_nodes) labels[node->index] = node->index;
+
+  Int_Vec new_labels = labels;
+  Int_Vec passed_on(nodes.size() * n_types, -1); // Node index x type
+
+  for (int pass = 0; pass < max_passes; pass++) {
+    if (n_types > 1) {
+      for_each_node_in_parallel(all_nodes, num_threads, [&](const Node* node) {
+        std::unordered_map<int, int> label_counts;
+
+        for (int type_i = 0; type_i < n_types; type_i++) {
+          if (type_i == node->type_index) continue;
+
+          label_counts.clear();
+          for (const Node* neighbor : node->get_edges_to_type(type_i)) {
+            label_counts[labels[neighbor->index]]++;
+          }
+          passed_on[node->index * n_types + type_i] = most_common_label(label_counts, -1, salt);
+        }
+      });
+    }
+
+    std::atomic<int> num_changed(0);
+
+    for_each_node_in_parallel(all_nodes, num_threads, [&](const Node* node) {
+      std::unordered_map<int, int> label_counts;
+
+      for (int type_i = 0; type_i < n_types; type_i++) {
+        for (const Node* neighbor : node->get_edges_to_type(type_i)) {
+          const int label = type_i == node->type_index
+                                ? labels[neighbor->index]
+                                : passed_on[neighbor->index * n_types + node->type_index];
+          if (label != -1) label_counts[label]++;
+        }
+      }
+
+      const int current = labels[node->index];
+      const int best = label_counts.empty() ? current
+                                            : most_common_label(label_counts, current, salt);
+      new_labels[node->index] = best;
+      if (best != current) num_changed++;
+    });
+
+    labels.swap(new_labels);
+    if (num_changed == 0) break;
+  }
+
+  return Group_Keys(labels.begin(), labels.end());
+}
+
+// Smallest hash over a node's neighbors, mixed with its degree class (log2 of degree)
+inline Group_Keys signature_keys(const Node_Container& nodes,
+                                 Random_Engine& random_engine,
+                                 const int num_threads = 1) {
+  const std::uint64_t salt = random_engine();
+  const Node_Ptrs all_nodes = all_nodes_of(nodes);
+  Group_Keys keys(nodes.size());
+
+  for_each_node_in_parallel(all_nodes, num_threads, [&](const Node* node) {
+    std::uint64_t min_hash = std::numeric_limits<std::uint64_t>::max();
+
+    for (const auto& edges_of_type : node->get_edges()) {
+      for (const Node* neighbor : edges_of_type) {
+        min_hash = std::min(min_hash, mix_hash(neighbor->index ^ salt));
+      }
+    }
+
+    // Unconnected nodes stand alone
+    if (node->get_degree() == 0) min_hash = mix_hash(node->index ^ salt);
+
+    int degree_class = 0;
+    for (int degree = node->get_degree(); degree > 1; degree >>= 1) degree_class++;
+
+    keys[node->index] = mix_hash(min_hash + degree_class);
+  });
+
+  return keys;
+}
+
+// Packs groups of nodes (nodes sharing a key) into `num_blocks` blocks per type,
+// biggest groups first into whichever block is currently smallest. Blocks left empty
+// (fewer groups than blocks) take a node from the biggest block. Returns each node's
+// block, 0 based within its type, by node index.
+inline Int_Vec pack_groups_into_blocks(const Node_Container& nodes,
+                                       const Group_Keys& keys,
+                                       const int num_blocks) {
+  Int_Vec block_of_node(nodes.size());
+
+  for (const auto& nodes_of_type : nodes.nodes) {
+    std::unordered_map<std::uint64_t, int> group_sizes;
+    for (const auto& node : nodes_of_type) group_sizes[keys[node->index]]++;
+
+    std::vector<std::pair<int, std::uint64_t>> groups; // (size, key)
+    groups.reserve(group_sizes.size());
+    for (const auto& group : group_sizes) groups.emplace_back(group.second, group.first);
+    std::sort(groups.begin(), groups.end(), [](const std::pair<int, std::uint64_t>& a,
+                                               const std::pair<int, std::uint64_t>& b) {
+      return a.first != b.first ? a.first > b.first : a.second < b.second;
+    });
+
+    // Smallest block (ties to the lowest block) on top
+    using Load = std::pair<int, int>; // (size, block)
+    std::priority_queue<Load, std::vector<Load>, std::greater<Load>> smallest_block;
+    for (int block_i = 0; block_i < num_blocks; block_i++) smallest_block.emplace(0, block_i);
+
+    std::unordered_map<std::uint64_t, int> block_of_group;
+    for (const auto& group : groups) {
+      Load load = smallest_block.top();
+      smallest_block.pop();
+
+      block_of_group[group.second] = load.second;
+      smallest_block.emplace(load.first + group.first, load.second);
+    }
+
+    std::vector<Node_Ptrs> block_members(num_blocks);
+    for (const auto& node : nodes_of_type) {
+      const int block_i = block_of_group[keys[node->index]];
+      block_of_node[node->index] = block_i;
+      block_members[block_i].push_back(node.get());
+    }
+
+    // There are at least as many nodes as blocks so the biggest block always has a spare
+    for (int empty_i = 0; empty_i < num_blocks; empty_i++) {
+      if (!block_members[empty_i].empty()) continue;
+
+      const int biggest_i = std::max_element(block_members.begin(), block_members.end(),
+                                             [](const Node_Ptrs& a, const Node_Ptrs& b) {
+                                               return a.size() < b.size();
+                                             }) - block_members.begin();
+      Node* moved = block_members[biggest_i].back();
+      block_members[biggest_i].pop_back();
+      block_members[empty_i].push_back(moved);
+      block_of_node[moved->index] = empty_i;
+    }
+  }
+
+  return block_of_node;
+}
+
+// Builds the starting blocks for a set of nodes. Only random uses the engine for more
+// than a single salt value.
+inline Node_Container initial_blocks(const int num_blocks,
+                                     Node_Container& child_nodes,
+                                     Random_Engine& random_engine,
+                                     const Block_Init block_init = Block_Init::random,
+                                     const int num_threads = 1) {
+  if (block_init == Block_Init::random) {
+    return Node_Container(num_blocks, child_nodes, random_engine);
+  }
+
+  // Catch bad block counts before any threads get started
+  for (int type_i = 0; type_i < child_nodes.num_types(); type_i++) {
+    if (num_blocks > child_nodes.size_of_type(type_i)) {
+      stop("Can't initialize more blocks than there are nodes of a given type");
+    }
+  }
+
+  const Group_Keys keys = block_init == Block_Init::label_propagation
+                              ? label_propagation_keys(child_nodes, random_engine, num_threads)
+                              : signature_keys(child_nodes, random_engine, num_threads);
+
+  return Node_Container(num_blocks, child_nodes,
+                        pack_groups_into_blocks(child_nodes, keys, num_blocks));
+}
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef __PARALLEL_HELPERS_INCLUDED__
+#define __PARALLEL_HELPERS_INCLUDED__
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <thread>
+#include <vector>
+
+// Number of threads to use when caller doesn't care (`num_threads <= 0`)
+inline int resolve_num_threads(const int num_threads, const int num_tasks) {
+  int n = num_threads > 0 ? num_threads : int(std::thread::hardware_concurrency());
+  return std::max(1, std::min(n, num_tasks));
+}
+
+// Runs `task(i)` for every i in [0, num_tasks) across a pool of threads that
+// each pull the next unclaimed task. Tasks must not touch the R API. The first
+// exception thrown by any task is rethrown on the calling thread once all the
+// workers have finished.
+template <typename Task>
+void run_in_parallel(const int num_tasks, const int num_threads, const Task& task) {
+  const int n_threads = resolve_num_threads(num_threads, num_tasks);
+
+  // No need to spin up threads for a single worker
+  if (n_threads == 1) {
+    for (int i = 0; i < num_tasks; i++) task(i);
+    return;
+  }
+
+  std::atomic<int> next_task(0);
+  std::exception_ptr first_error = nullptr;
+  std::atomic_flag error_claimed = ATOMIC_FLAG_INIT;
+
+  auto worker = [&]() {
+    for (int i = next_task++; i < num_tasks; i = next_task++) {
+      try {
+        task(i);
+      } catch (...) {
+        if (!error_claimed.test_and_set()) first_error = std::current_exception();
+        next_task = num_tasks; // Don't bother starting anything else
+      }
+    }
+  };
+
+  std::vector<std::thread> workers;
+  workers.reserve(n_threads);
+  for (int i = 0; i < n_threads; i++) workers.emplace_back(worker);
+  for (auto& thread : workers) thread.join();
+
+  if (first_error) std::rethrow_exception(first_error);
+}
+
+#endif
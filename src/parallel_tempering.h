@@ -0,0 +1,106 @@
+#ifndef __PARALLEL_TEMPERING_INCLUDED__
+#define __PARALLEL_TEMPERING_INCLUDED__
+
+#include "run_chains.h"
+
+struct Tempering_Results {
+  Double_Vec betas;
+  // Entropy of the replica at each beta after every exchange round (one vector
+  // per beta, in the same order as `betas`)
+  std::vector<Double_Vec> entropy_traces;
+  // Final block assignments of the replica sitting at each beta
+  std::vector<Int_Vec> block_assignments;
+  // Proportion of accepted exchanges between betas i and i + 1
+  Double_Vec swap_acceptance;
+};
+
+// Runs one replica of the model per inverse temperature in `betas`, each on
+// its own thread. Every `swap_interval` sweeps, neighboring temperatures try
+// to exchange states with probability min(1, exp((b_i - b_j) * (S_i - S_j))).
+// Rather than moving whole states between replicas the betas are exchanged,
+// which is equivalent and free. Even and odd neighbor pairs alternate rounds.
+inline Tempering_Results run_parallel_tempering(const Node_Container& network,
+                                                const Edge_Container& edges,
+                                                const int num_blocks,
+                                                const int num_sweeps,
+                                                const Double_Vec& betas,
+                                                const int swap_interval,
+                                                const int seed,
+                                                const double eps = 0.1,
+                                                const int num_threads = 0) {
+  const int num_replicas = betas.size();
+  if (num_replicas < 2) stop("Parallel tempering needs at least two betas");
+  if (swap_interval < 1) stop("Swap interval must be at least one sweep");
+
+  for (int type_i = 0; type_i < network.num_types(); type_i++) {
+    if (num_blocks > network.size_of_type(type_i)) {
+      stop("Can't initialize more blocks than there are nodes of a given type");
+    }
+  }
+
+  std::vector<std::unique_ptr<SBM>> replicas(num_replicas);
+  Double_Vec replica_entropy(num_replicas);
+
+  run_in_parallel(num_replicas, num_threads, [&](const int replica_i) {
+    replicas[replica_i].reset(new SBM(network, edges, num_blocks,
+                                      chain_random_engine(seed, replica_i)));
+    replica_entropy[replica_i] = replicas[replica_i]->entropy();
+  });
+
+  // Which replica is currently running at each beta
+  Int_Vec replica_at_beta(num_replicas);
+  std::iota(replica_at_beta.begin(), replica_at_beta.end(), 0);
+
+  Tempering_Results results;
+  results.betas = betas;
+  results.entropy_traces = std::vector<Double_Vec>(num_replicas);
+  results.swap_acceptance = Double_Vec(num_replicas - 1, 0.0);
+  Int_Vec swap_attempts(num_replicas - 1, 0);
+
+  // Exchanges get their own stream so they don't depend on thread timing
+  Random_Engine swap_engine = chain_random_engine(seed, num_replicas);
+  std::uniform_real_distribution<> runif;
+
+  const int num_rounds = (num_sweeps + swap_interval - 1) / swap_interval;
+
+  for (int round = 0; round < num_rounds; round++) {
+    const int sweeps_this_round = std::min(swap_interval, num_sweeps - round * swap_interval);
+
+    run_in_parallel(num_replicas, num_threads, [&](const int beta_i) {
+      const int replica_i = replica_at_beta[beta_i];
+      SBM& replica = *replicas[replica_i];
+
+      for (int i = 0; i < sweeps_this_round; i++) {
+        replica_entropy[replica_i] += replica.mcmc_sweep(eps, betas[beta_i]).entropy_delta;
+      }
+    });
+
+    for (int beta_i = round % 2; beta_i < num_replicas - 1; beta_i += 2) {
+      const double ent_i = replica_entropy[replica_at_beta[beta_i]];
+      const double ent_j = replica_entropy[replica_at_beta[beta_i + 1]];
+      const double accept_prob = std::exp((betas[beta_i] - betas[beta_i + 1]) * (ent_i - ent_j));
+
+      swap_attempts[beta_i]++;
+      if (runif(swap_engine) < accept_prob) {
+        std::swap(replica_at_beta[beta_i], replica_at_beta[beta_i + 1]);
+        results.swap_acceptance[beta_i]++;
+      }
+    }
+
+    for (int beta_i = 0; beta_i < num_replicas; beta_i++) {
+      results.entropy_traces[beta_i].push_back(replica_entropy[replica_at_beta[beta_i]]);
+    }
+  }
+
+  for (int i = 0; i < num_replicas - 1; i++) {
+    if (swap_attempts[i] > 0) results.swap_acceptance[i] /= swap_attempts[i];
+  }
+
+  for (const int replica_i : replica_at_beta) {
+    results.block_assignments.push_back(replicas[replica_i]->block_assignments());
+  }
+
+  return results;
+}
+
+#endif
@@ -0,0 +1,20 @@
+#ifndef __RCPP_ADAPTER_INCLUDED__
+#define __RCPP_ADAPTER_INCLUDED__
+
+// The only place the model code meets Rcpp. Everything else builds without R, see
+// `String_Column` for how strings come in and `error_helpers.h` for how errors go out.
+#include <Rcpp.h>
+#include "String_Column.h"
+
+// Character vectors become columns of pointers into R's string cache. R keeps a single
+// copy of every distinct string, so equal strings share an address. Reading them all
+// here, on the calling thread, also means worker threads never touch R objects.
+template <>
+struct String_Source<Rcpp::CharacterVector> {
+  static void append(const Rcpp::CharacterVector& source, std::vector<const char*>& strings) {
+    strings.reserve(strings.size() + source.size());
+    for (int i = 0; i < source.size(); i++) strings.push_back(CHAR(STRING_ELT(source, i)));
+  }
+};
+
+#endif
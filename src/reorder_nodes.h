@@ -0,0 +1,124 @@
+#ifndef __REORDER_NODES_INCLUDED__
+#define __REORDER_NODES_INCLUDED__
+// Reorders the nodes of a network so that nodes that are connected sit close to each
+// other, which keeps neighbor lookups in cache when sweeping through the network. Nodes
+// keep their `index`, and with it their id, so output is unaffected; only their position
+// in the container changes. Nodes are still grouped by type, within a type they follow
+// the order chosen across the whole network.
+//
+// Positions are what matter for copies of the network (e.g. `Node_Container::clone()`)
+// which allocate their nodes in container order, and for fixed-order sweeps.
+
+#include <deque>
+#include "Node_Container.h"
+
+enum class Node_Order {
+  input,  // Leave nodes in the order they were provided
+  degree, // Highest degree nodes first
+  bfs,    // Breadth first search order, one connected component at a time
+  rcm     // Reverse Cuthill-McKee: BFS from low degree nodes, lowest degree neighbors
+          // first, then reversed. Keeps the bandwidth of the adjacency matrix small
+};
+
+inline Node_Order node_order_from_name(const string& order_name) {
+  if (order_name == "input") return Node_Order::input;
+  if (order_name == "degree") return Node_Order::degree;
+  if (order_name == "bfs") return Node_Order::bfs;
+  if (order_name == "rcm") return Node_Order::rcm;
+  stop("Node order must be one of input, degree, bfs, or rcm");
+}
+
+// Breadth first ordering of every node. Components are started from the first
+// unvisited node in `start_order`; with `lowest_degree_first` neighbors get queued in
+// order of increasing degree rather than edge order
+inline Node_Ptrs breadth_first_order(const Node_Ptrs& start_order,
+                                     const int num_nodes,
+                                     const bool lowest_degree_first) {
+  auto lower_degree = [](const Node* a, const Node* b) {
+    return a->get_degree() < b->get_degree();
+  };
+
+  Node_Ptrs order;
+  order.reserve(num_nodes);
+  std::vector<char> visited(num_nodes, false);
+  Node_Ptrs neighbors;
+
+  for (Node* start : start_order) {
+    if (visited[start->index]) continue;
+
+    visited[start->index] = true;
+    std::deque<Node*> queue{start};
+
+    while (!queue.empty()) {
+      Node* node = queue.front();
+      queue.pop_front();
+      order.push_back(node);
+
+      neighbors.clear();
+      for (const auto& neighbors_of_type : node->get_edges()) {
+        for (const auto& neighbor : neighbors_of_type) {
+          if (!visited[neighbor->index]) {
+            visited[neighbor->index] = true;
+            neighbors.push_back(neighbor);
+          }
+        }
+      }
+
+      if (lowest_degree_first) {
+        std::stable_sort(neighbors.begin(), neighbors.end(), lower_degree);
+      }
+      queue.insert(queue.end(), neighbors.begin(), neighbors.end());
+    }
+  }
+
+  return order;
+}
+
+inline void reorder_nodes(Node_Container& nodes, const Node_Order node_order) {
+  if (node_order == Node_Order::input) return;
+
+  Node_Ptrs current_order;
+  current_order.reserve(nodes.size());
+  for (const auto& nodes_of_type : nodes.nodes) {
+    for (const auto& node : nodes_of_type) current_order.push_back(node.get());
+  }
+
+  Node_Ptrs new_order;
+
+  if (node_order == Node_Order::degree) {
+    new_order = current_order;
+    std::stable_sort(new_order.begin(), new_order.end(), [](const Node* a, const Node* b) {
+      return a->get_degree() > b->get_degree();
+    });
+  } else if (node_order == Node_Order::bfs) {
+    new_order = breadth_first_order(current_order, nodes.size(), false);
+  } else {
+    // Cuthill-McKee starts each component from its lowest degree node
+    Node_Ptrs by_degree = current_order;
+    std::stable_sort(by_degree.begin(), by_degree.end(), [](const Node* a, const Node* b) {
+      return a->get_degree() < b->get_degree();
+    });
+    new_order = breadth_first_order(by_degree, nodes.size(), true);
+    std::reverse(new_order.begin(), new_order.end());
+  }
+
+  // Position of every node (by index) in the new order
+  std::vector<int> position(nodes.size());
+  for (int i = 0; i < new_order.size(); i++) position[new_order[i]->index] = i;
+
+  for (auto& nodes_of_type : nodes.nodes) {
+    std::sort(nodes_of_type.begin(), nodes_of_type.end(),
+              [&position](const Node_Unique_Ptr& a, const Node_Unique_Ptr& b) {
+                return position[a->index] < position[b->index];
+              });
+  }
+
+  // Walk neighbors in the same order too
+  for (Node* node : current_order) {
+    node->sort_edges([&position](const Node* a, const Node* b) {
+      return position[a->index] < position[b->index];
+    });
+  }
+}
+
+#endif
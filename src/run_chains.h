@@ -0,0 +1,108 @@
+#ifndef __RUN_CHAINS_INCLUDED__
+#define __RUN_CHAINS_INCLUDED__
+
+#include "Convergence_Monitor.h"
+#include "Eps_Tuner.h"
+#include "SBM.h"
+#include "beta_schedule.h"
+#include "parallel_helpers.h"
+
+using Double_Vec = std::vector<double>;
+
+struct Chain_Results {
+  Double_Vec entropy_trace; // Entropy at start and after every sweep
+  Int_Vec block_assignments;  // Block index for each node, in node index order
+  Stop_Reason stop_reason = Stop_Reason::max_sweeps;
+  Double_Vec eps_by_type;  // The eps each node type ended up with
+  double entropy() const { return entropy_trace.back(); }
+  int num_sweeps() const { return entropy_trace.size() - 1; }
+};
+
+struct Multi_Chain_Results {
+  std::vector<Chain_Results> chains;
+  int best_chain = 0; // Index of chain with the lowest final entropy
+};
+
+// Each chain gets its own stream of random numbers, seeded by both the overall
+// seed and the chain's position so results don't depend on the thread count
+inline Random_Engine chain_random_engine(const int seed, const int chain_i) {
+  std::seed_seq chain_seeds{seed, chain_i};
+  return Random_Engine(chain_seeds);
+}
+
+// Fits `num_chains` independent chains of the same network in parallel. The
+// network's nodes and edges are only read; each chain works on its own copy.
+// Every chain follows the same `beta_schedule` and `sweep_order` over its sweeps
+// and starts from blocks picked with `block_init`. Chains stop before `num_sweeps`
+// if `convergence` says they have become stationary. With `eps_tuning` each chain
+// tunes its own eps per node type over its first sweeps, which don't count towards
+// convergence.
+inline Multi_Chain_Results run_chains(const Node_Container& network,
+                                      const Edge_Container& edges,
+                                      const int num_blocks,
+                                      const int num_sweeps,
+                                      const int num_chains,
+                                      const int seed,
+                                      const double eps = 0.1,
+                                      const int num_threads = 0,
+                                      const Beta_Schedule& beta_schedule = Beta_Schedule(),
+                                      const Sweep_Order sweep_order = Sweep_Order::fixed,
+                                      const Block_Init block_init = Block_Init::random,
+                                      const Convergence_Settings& convergence = Convergence_Settings(),
+                                      const Eps_Tuning& eps_tuning = Eps_Tuning()) {
+  if (num_chains < 1) stop("Need at least one chain");
+
+  // Catch bad block counts before any chains start rather than in every one of them
+  for (int type_i = 0; type_i < network.num_types(); type_i++) {
+    if (num_blocks > network.size_of_type(type_i)) {
+      stop("Can't initialize more blocks than there are nodes of a given type");
+    }
+  }
+
+  // Checked up front for the same reason, each chain starts from a copy
+  const Eps_Tuner starting_eps(network.num_types(), eps, eps_tuning);
+
+  Multi_Chain_Results results;
+  results.chains = std::vector<Chain_Results>(num_chains);
+
+  run_in_parallel(num_chains, num_threads, [&](const int chain_i) {
+    SBM sbm(network, edges, num_blocks, chain_random_engine(seed, chain_i), sweep_order,
+            block_init);
+    Chain_Results& chain = results.chains[chain_i];
+
+    chain.entropy_trace.reserve(num_sweeps + 1);
+    chain.entropy_trace.push_back(sbm.entropy());
+    Convergence_Monitor monitor(convergence);
+    Eps_Tuner eps_tuner = starting_eps;
+
+    for (int i = 0; i < num_sweeps; i++) {
+      const double beta = beta_schedule.beta_at(i, num_sweeps);
+      const Sweep_Results sweep = sbm.mcmc_sweep(eps_tuner.get_eps(), beta);
+      chain.entropy_trace.push_back(chain.entropy_trace.back() + sweep.entropy_delta);
+
+      if (!eps_tuner.is_frozen()) {
+        eps_tuner.update(sweep.proposed_by_type, sweep.moved_by_type);
+        continue;
+      }
+
+      const double acceptance_rate =
+          sweep.num_nodes_visited > 0 ? double(sweep.num_nodes_moved) / sweep.num_nodes_visited : 0.0;
+      if (monitor.add_sweep(chain.entropy(), acceptance_rate)) break;
+    }
+
+    chain.stop_reason = monitor.stop_reason();
+    chain.eps_by_type = eps_tuner.get_eps();
+
+    chain.block_assignments = sbm.block_assignments();
+  });
+
+  for (int i = 1; i < num_chains; i++) {
+    if (results.chains[i].entropy() < results.chains[results.best_chain].entropy()) {
+      results.best_chain = i;
+    }
+  }
+
+  return results;
+}
+
+#endif
@@ -0,0 +1,221 @@
+#include "rcpp_adapter.h"
+#include "SBM_Model.h"
+
+using namespace Rcpp;
+
+// A model is created once with `new_sbm_model()` and then handed back to the other
+// `model_*()` functions, which sweep or read from it in place.
+
+// External pointers come back as NULL after a session is saved and reloaded
+SBM_Model& model_from_ptr(SEXP model_ptr) {
+  XPtr<SBM_Model> model(model_ptr);
+  if (model.get() == nullptr) Rcpp::stop("Model no longer exists, it needs to be created again");
+  return *model;
+}
+
+// Ingests a network and assigns its nodes to `num_blocks` blocks per type.
+// `sweep_order`, `node_order` and `block_init` are the same as for `fit_chains()`.
+// `num_threads` is used when reading in the edges and picking the starting blocks.
+// [[Rcpp::export]]
+SEXP new_sbm_model(const CharacterVector nodes_id,
+                   const CharacterVector nodes_type,
+                   const CharacterVector types_name,
+                   const IntegerVector types_count,
+                   const CharacterVector edges_from,
+                   const CharacterVector edges_to,
+                   const int num_blocks,
+                   const int seed = 42,
+                   const std::string sweep_order = "fixed",
+                   const std::string node_order = "input",
+                   const std::string block_init = "random",
+                   const int num_threads = 1) {
+  return XPtr<SBM_Model>(new SBM_Model(nodes_id, nodes_type, types_name, types_count,
+                                       edges_from, edges_to, num_blocks, seed,
+                                       sweep_order_from_name(sweep_order),
+                                       node_order_from_name(node_order),
+                                       block_init_from_name(block_init), num_threads),
+                         true);
+}
+
+// Runs more sweeps, continuing from wherever the model was left. Returns the entropy
+// after each of the new sweeps.
+// [[Rcpp::export]]
+NumericVector model_run_sweeps(SEXP model,
+                               const int num_sweeps,
+                               const double eps = 0.1,
+                               const double beta = 1.0) {
+  const Double_Vec entropies = model_from_ptr(model).run_sweeps(num_sweeps, eps, beta);
+  return NumericVector(entropies.begin(), entropies.end());
+}
+
+// Block index of every node, in order of `nodes_id`
+// [[Rcpp::export]]
+IntegerVector model_assignments(SEXP model) {
+  const SBM_Model& sbm_model = model_from_ptr(model);
+  IntegerVector assignments(sbm_model.num_nodes());
+  write_block_assignments(sbm_model.get_nodes(), assignments.begin());
+  return assignments;
+}
+
+// Nonzero edge counts between blocks as row `i`, column `j` and count `x`, ready for
+// `Matrix::sparseMatrix()` along with `dims`. Block index b (as in
+// `model_assignments()`) is row and column b + 1. Within-block edges are counted
+// twice on the diagonal.
+// [[Rcpp::export]]
+List model_block_edge_counts(SEXP model) {
+  const Node_Container& blocks = model_from_ptr(model).get_blocks();
+  const int num_entries = num_block_edge_entries(blocks);
+  const int span = block_index_span(blocks);
+
+  IntegerVector rows(num_entries);
+  IntegerVector cols(num_entries);
+  IntegerVector counts(num_entries);
+  write_block_edge_triplets(blocks, rows.begin(), cols.begin(), counts.begin(), 1);
+
+  return List::create(
+      _["i"] = rows,
+      _["j"] = cols,
+      _["x"] = counts,
+      _["dims"] = IntegerVector{span, span});
+}
+
+// The same counts as `model_block_edge_counts()` as a dense matrix, for when there
+// are few blocks
+// [[Rcpp::export]]
+IntegerMatrix model_block_matrix(SEXP model) {
+  const Node_Container& blocks = model_from_ptr(model).get_blocks();
+  const int span = block_index_span(blocks);
+
+  IntegerMatrix block_matrix(span, span);
+  write_block_edge_matrix(blocks, span, block_matrix.begin());
+  return block_matrix;
+}
+
+// Every block's index, type (1 based position in `types_name`), number of nodes and
+// degree
+// [[Rcpp::export]]
+List model_block_stats(SEXP model) {
+  const Node_Container& blocks = model_from_ptr(model).get_blocks();
+  const int num_blocks = blocks.size();
+
+  IntegerVector indices(num_blocks);
+  IntegerVector types(num_blocks);
+  IntegerVector sizes(num_blocks);
+  IntegerVector degrees(num_blocks);
+  write_block_stats(blocks, indices.begin(), types.begin(), sizes.begin(), degrees.begin());
+  for (int& type : types) type++;
+
+  return List::create(
+      _["block"] = indices,
+      _["type"] = types,
+      _["size"] = sizes,
+      _["degree"] = degrees);
+}
+
+// [[Rcpp::export]]
+double model_entropy(SEXP model) {
+  return model_from_ptr(model).entropy();
+}
+
+// Copy of the model's current state as plain R values, safe to keep after the
+// model itself is gone
+// [[Rcpp::export]]
+List model_snapshot(SEXP model) {
+  SBM_Model& sbm_model = model_from_ptr(model);
+  const Double_Vec& entropy_trace = sbm_model.get_entropy_trace();
+  IntegerVector assignments(sbm_model.num_nodes());
+  write_block_assignments(sbm_model.get_nodes(), assignments.begin());
+
+  return List::create(
+      _["num_sweeps"] = sbm_model.num_sweeps(),
+      _["num_blocks"] = sbm_model.num_blocks(),
+      _["entropy"] = sbm_model.entropy(),
+      _["entropy_trace"] = NumericVector(entropy_trace.begin(), entropy_trace.end()),
+      _["assignments"] = assignments);
+}
+
+// How often the model's caches have saved work so far: neighbor block histograms
+// reused rather than rebuilt, and proposed moves whose score was reused
+// [[Rcpp::export]]
+List model_cache_stats(SEXP model) {
+  SBM_Model& sbm_model = model_from_ptr(model);
+  const Neighbor_Histograms& histograms = sbm_model.get_histograms();
+  const Move_Cache& move_cache = sbm_model.get_move_cache();
+
+  return List::create(
+      _["histogram_hits"] = double(histograms.get_num_hits()),
+      _["histogram_builds"] = double(histograms.get_num_builds()),
+      _["move_lookups"] = double(move_cache.get_num_lookups()),
+      _["move_hits"] = double(move_cache.get_num_hits()),
+      _["move_hit_rate"] = move_cache.hit_rate());
+}
+
+// Bytes each part of the model holds, for sizing machines: one row per part of the
+// network's nodes and edges, the chain's copy of the nodes, its blocks, its per node
+// caches and sweep schedule, and the marginals once started. `bytes` count vector
+// capacity and map nodes, `allocations` the separate heap blocks behind them.
+// [[Rcpp::export]]
+List model_memory_usage(SEXP model) {
+  const auto usage = model_from_ptr(model).memory_usage();
+
+  int num_parts = 0;
+  for (const auto& structure : usage) num_parts += structure.second.get_parts().size();
+
+  CharacterVector structure_names(num_parts);
+  CharacterVector part_names(num_parts);
+  NumericVector bytes(num_parts);
+  NumericVector allocations(num_parts);
+
+  int row = 0;
+  for (const auto& structure : usage) {
+    for (const Memory_Part& part : structure.second.get_parts()) {
+      structure_names[row] = structure.first;
+      part_names[row] = part.name;
+      bytes[row] = double(part.bytes);
+      allocations[row] = double(part.allocations);
+      row++;
+    }
+  }
+
+  return List::create(
+      _["structure"] = structure_names,
+      _["part"] = part_names,
+      _["bytes"] = bytes,
+      _["allocations"] = allocations);
+}
+
+// Start tallying how often nodes sit in each block over the sweeps that follow,
+// replacing any earlier tally. Pairs sharing a block are also tallied for the nodes
+// at (1 based) positions `node_subset` of `nodes_id`.
+// [[Rcpp::export]]
+void model_start_marginals(SEXP model, const IntegerVector node_subset = IntegerVector()) {
+  Int_Vec subset_indices;
+  subset_indices.reserve(node_subset.size());
+  for (const int node_position : node_subset) subset_indices.push_back(node_position - 1);
+
+  model_from_ptr(model).start_marginals(subset_indices);
+}
+
+// Proportion of sweeps since `model_start_marginals()` each node spent in each block
+// (rows in order of `nodes_id`, columns by block index) and each pair of subset nodes
+// spent in the same block (rows and columns in order of `node_subset`)
+// [[Rcpp::export]]
+List model_marginals(SEXP model) {
+  SBM_Model& sbm_model = model_from_ptr(model);
+  const Marginal_Accumulator& marginals = sbm_model.get_marginals();
+
+  const int num_block_columns = sbm_model.num_block_columns();
+  const Double_Vec block_marginals = marginals.block_marginals(num_block_columns);
+  const Double_Vec co_occurrence = marginals.co_occurrence();
+
+  NumericMatrix block_matrix(sbm_model.num_nodes(), num_block_columns);
+  std::copy(block_marginals.begin(), block_marginals.end(), block_matrix.begin());
+
+  NumericMatrix co_occurrence_matrix(marginals.subset_size(), marginals.subset_size());
+  std::copy(co_occurrence.begin(), co_occurrence.end(), co_occurrence_matrix.begin());
+
+  return List::create(
+      _["num_samples"] = marginals.get_num_samples(),
+      _["block_marginals"] = block_matrix,
+      _["co_occurrence"] = co_occurrence_matrix);
+}
@@ -0,0 +1,399 @@
+#ifndef __SELECT_NUM_BLOCKS_INCLUDED__
+#define __SELECT_NUM_BLOCKS_INCLUDED__
+
+#include <cmath>
+#include <iterator>
+#include <map>
+#include <memory>
+#include "run_chains.h"
+
+// Picking the number of blocks B (the same for every node type) by the description
+// length of the fitted model: the entropy of the network given the blocks plus what
+// it takes to describe the blocks themselves. Entropy alone only ever falls as B grows.
+
+inline double x_log_x(const double x) { return x > 0 ? x * std::log(x) : 0.0; }
+
+// Description length of the blocks, following Peixoto (2013): which block each node is
+// in (N_t log B per type) and the edge counts between the M pairs of blocks that can
+// have edges between them, E h(M / E) with h(x) = (1 + x) log(1 + x) - x log x
+inline double model_description_length(const Node_Container& network,
+                                       const Edge_Container& edges,
+                                       const int num_blocks) {
+  double length = 0.0;
+  double num_block_pairs = 0.0;
+
+  for (int type_i = 0; type_i < network.num_types(); type_i++) {
+    length += network.size_of_type(type_i) * std::log(double(num_blocks));
+
+    for (const int neighbor_type : edges.neighbor_types_for_node(type_i)) {
+      if (neighbor_type == type_i) num_block_pairs += num_blocks * (num_blocks + 1.0) / 2.0;
+      else if (neighbor_type > type_i) num_block_pairs += double(num_blocks) * num_blocks;
+    }
+  }
+
+  const double num_edges = edges.size();
+  if (num_edges > 0) {
+    const double x = num_block_pairs / num_edges;
+    length += num_edges * (x_log_x(1.0 + x) - x_log_x(x));
+  }
+
+  return length;
+}
+
+// Each node's block, 0 based within its type, by node index
+inline Int_Vec block_positions(const Node_Container& blocks, const int num_nodes) {
+  Int_Vec positions(num_nodes, 0);
+  for (const auto& blocks_of_type : blocks.nodes) {
+    for (int block_i = 0; block_i < blocks_of_type.size(); block_i++) {
+      for (const Node* child : blocks_of_type[block_i]->children) positions[child->index] = block_i;
+    }
+  }
+  return positions;
+}
+
+// Brings a partition with `from_blocks` blocks per type down to `to_blocks` by merging
+// blocks of the same type. Each round every block finds the partner whose merge raises
+// the entropy least, then the cheapest of those merges that don't share a block are
+// made, up to as many as are still needed. Works on the B x B block edge counts so a
+// round is O(B^3) whatever the size of the network.
+inline Int_Vec merge_blocks(const Node_Container& network,
+                            const Edge_Container& edges,
+                            const Int_Vec& positions,
+                            const int from_blocks,
+                            const int to_blocks) {
+  const int num_global = network.num_types() * from_blocks;
+  auto global_block = [&](const Node* node) {
+    return node->type_index * from_blocks + positions[node->index];
+  };
+
+  std::vector<double> counts(num_global * num_global, 0.0);
+  Double_Vec degrees(num_global, 0.0);
+  for (const auto& edge : edges.data()) {
+    const int r = global_block(edge.first());
+    const int s = global_block(edge.second());
+    counts[r * num_global + s]++;
+    counts[s * num_global + r]++;
+    degrees[r]++;
+    degrees[s]++;
+  }
+  auto count = [&](const int r, const int s) { return counts[r * num_global + s]; };
+
+  // Change in entropy from merging r and s, only the rows and columns of r and s move
+  auto merge_delta = [&](const int r, const int s) {
+    double delta = 0.0;
+    for (int t = 0; t < num_global; t++) {
+      if (t == r || t == s) continue;
+      delta -= x_log_x(count(r, t) + count(s, t)) - x_log_x(count(r, t)) - x_log_x(count(s, t));
+    }
+    const double merged_self = count(r, r) + count(s, s) + 2 * count(r, s);
+    delta -= 0.5 * (x_log_x(merged_self) - x_log_x(count(r, r)) - x_log_x(count(s, s)) -
+                    2 * x_log_x(count(r, s)));
+    return delta + x_log_x(degrees[r] + degrees[s]) - x_log_x(degrees[r]) - x_log_x(degrees[s]);
+  };
+
+  Int_Vec merged_into(num_global);
+  for (int r = 0; r < num_global; r++) merged_into[r] = r;
+
+  for (int type_i = 0; type_i < network.num_types(); type_i++) {
+    Int_Vec alive;
+    for (int block_i = 0; block_i < from_blocks; block_i++) alive.push_back(type_i * from_blocks + block_i);
+
+    while (alive.size() > to_blocks) {
+      std::vector<std::pair<double, std::pair<int, int>>> best_merges;
+      for (const int r : alive) {
+        int best_partner = -1;
+        double best_delta = 0.0;
+        for (const int s : alive) {
+          if (s == r) continue;
+          const double delta = merge_delta(r, s);
+          if (best_partner == -1 || delta < best_delta) {
+            best_partner = s;
+            best_delta = delta;
+          }
+        }
+        best_merges.push_back({best_delta, {r, best_partner}});
+      }
+      std::sort(best_merges.begin(), best_merges.end());
+
+      int num_needed = alive.size() - to_blocks;
+      std::vector<bool> used(num_global, false);
+      for (const auto& merge : best_merges) {
+        if (num_needed == 0) break;
+        const int r = merge.second.first;
+        const int s = merge.second.second;
+        if (used[r] || used[s]) continue;
+        used[r] = used[s] = true;
+        num_needed--;
+
+        // Fold s into r: rows first, then columns so the diagonal picks up both sides
+        for (int t = 0; t < num_global; t++) counts[r * num_global + t] += count(s, t);
+        for (int t = 0; t < num_global; t++) counts[t * num_global + r] += count(t, s);
+        for (int t = 0; t < num_global; t++) {
+          counts[s * num_global + t] = 0.0;
+          counts[t * num_global + s] = 0.0;
+        }
+        degrees[r] += degrees[s];
+        degrees[s] = 0.0;
+        merged_into[s] = r;
+      }
+
+      alive.erase(std::remove_if(alive.begin(), alive.end(),
+                                 [&](const int r) { return merged_into[r] != r; }),
+                  alive.end());
+    }
+  }
+
+  // Surviving blocks keep their order within each type
+  Int_Vec new_position(num_global, -1);
+  for (int type_i = 0; type_i < network.num_types(); type_i++) {
+    int next_position = 0;
+    for (int block_i = 0; block_i < from_blocks; block_i++) {
+      const int r = type_i * from_blocks + block_i;
+      if (merged_into[r] == r) new_position[r] = next_position++;
+    }
+  }
+
+  auto root_of = [&](int r) {
+    while (merged_into[r] != r) r = merged_into[r];
+    return r;
+  };
+
+  Int_Vec new_positions(positions.size());
+  for (const auto& nodes_of_type : network.nodes) {
+    for (const auto& node : nodes_of_type) {
+      new_positions[node->index] = new_position[root_of(global_block(node.get()))];
+    }
+  }
+  return new_positions;
+}
+
+// Brings a partition with `from_blocks` blocks per type up to `to_blocks` by splitting
+// blocks of the same type in two, the block with the highest degree first. A block's
+// nodes are lined up by the block most of their neighbors are in so the two halves
+// each keep nodes that connect to the same places together.
+inline Int_Vec split_blocks(const Node_Container& network,
+                            const Int_Vec& positions,
+                            const int from_blocks,
+                            const int to_blocks) {
+  Int_Vec new_positions = positions;
+
+  for (int type_i = 0; type_i < network.num_types(); type_i++) {
+    std::vector<Node_Ptrs> members(to_blocks);
+    Int_Vec block_degrees(to_blocks, 0);
+    for (const auto& node : network.nodes[type_i]) {
+      members[positions[node->index]].push_back(node.get());
+      block_degrees[positions[node->index]] += node->get_degree();
+    }
+
+    for (int new_block = from_blocks; new_block < to_blocks; new_block++) {
+      int biggest = -1;
+      for (int block_i = 0; block_i < new_block; block_i++) {
+        if (members[block_i].size() < 2) continue;
+        if (biggest == -1 || block_degrees[block_i] > block_degrees[biggest]) biggest = block_i;
+      }
+
+      // Block (type and position) most of a node's neighbors are in, -1 for no neighbors
+      std::map<const Node*, int> main_neighbor_block;
+      for (const Node* node : members[biggest]) {
+        std::map<int, int> neighbor_blocks;
+        for (const auto& edges_of_type : node->get_edges()) {
+          for (const Node* neighbor : edges_of_type) {
+            neighbor_blocks[neighbor->type_index * to_blocks + new_positions[neighbor->index]]++;
+          }
+        }
+        int main_block = -1;
+        int main_count = 0;
+        for (const auto& neighbor_block : neighbor_blocks) {
+          if (neighbor_block.second > main_count) {
+            main_block = neighbor_block.first;
+            main_count = neighbor_block.second;
+          }
+        }
+        main_neighbor_block[node] = main_block;
+      }
+
+      Node_Ptrs& old_members = members[biggest];
+      std::sort(old_members.begin(), old_members.end(), [&](const Node* a, const Node* b) {
+        const int block_a = main_neighbor_block[a];
+        const int block_b = main_neighbor_block[b];
+        return block_a != block_b ? block_a < block_b : a->index < b->index;
+      });
+
+      const int half = old_members.size() / 2;
+      for (int i = half; i < old_members.size(); i++) {
+        Node* node = old_members[i];
+        new_positions[node->index] = new_block;
+        members[new_block].push_back(node);
+        block_degrees[new_block] += node->get_degree();
+        block_degrees[biggest] -= node->get_degree();
+      }
+      old_members.resize(half);
+    }
+  }
+
+  return new_positions;
+}
+
+// Starting blocks for `to_blocks` built from a fit with `from_blocks`
+inline Int_Vec warm_start_positions(const Node_Container& network,
+                                    const Edge_Container& edges,
+                                    const Int_Vec& positions,
+                                    const int from_blocks,
+                                    const int to_blocks) {
+  if (to_blocks < from_blocks) return merge_blocks(network, edges, positions, from_blocks, to_blocks);
+  if (to_blocks > from_blocks) return split_blocks(network, positions, from_blocks, to_blocks);
+  return positions;
+}
+
+struct Block_Count_Fit {
+  int num_blocks = 0;
+  int warm_start_from = 0;  // Blocks in the fit this one started from, 0 for a cold start
+  int round = 0;            // Search round the fit was made in
+  double entropy = 0.0;
+  double description_length = 0.0; // Entropy plus the model's description length
+  Int_Vec block_positions;  // Each node's block, 0 based within its type, by node index
+};
+
+struct Block_Count_Selection {
+  std::vector<Block_Count_Fit> fits; // In the order they were made
+  int best_fit = 0;                  // Index of the fit with the smallest description length
+};
+
+// Searches `min_blocks` to `max_blocks` for the number of blocks with the smallest
+// description length. Every round fits up to `candidates_per_round` evenly spaced
+// values inside the current bracket (the first round also fits both ends), each on
+// its own thread, then narrows the bracket to the fitted values either side of the
+// best so far. With two candidates a round this is a ternary search; more candidates
+// trade extra fits for fewer rounds. Stops once every value in the bracket is fitted.
+//
+// The first round starts each fit from `block_init`. Later fits start from the closest
+// fit made in an earlier round (the larger one on ties), merged or split to the new
+// number of blocks, then each fit runs `num_sweeps` sweeps. Every fit has its own
+// random stream seeded by `seed` and its number of blocks, so results don't depend on
+// the number of threads.
+inline Block_Count_Selection select_num_blocks(const Node_Container& network,
+                                               const Edge_Container& edges,
+                                               const int min_blocks,
+                                               const int max_blocks,
+                                               const int num_sweeps,
+                                               const int seed,
+                                               const double eps = 0.1,
+                                               const int num_threads = 0,
+                                               const int candidates_per_round = 4,
+                                               const Sweep_Order sweep_order = Sweep_Order::fixed,
+                                               const Block_Init block_init = Block_Init::random) {
+  if (min_blocks < 1 || min_blocks > max_blocks) stop("Need 1 <= min_blocks <= max_blocks");
+  if (candidates_per_round < 2) stop("Need at least two candidates a round");
+  if (num_sweeps < 0) stop("Can't run a negative number of sweeps");
+
+  // Catch bad block counts before any fits start, not partway through the search
+  for (int type_i = 0; type_i < network.num_types(); type_i++) {
+    if (max_blocks > network.size_of_type(type_i)) {
+      stop("Can't initialize more blocks than there are nodes of a given type");
+    }
+  }
+
+  Block_Count_Selection selection;
+  std::map<int, int> fit_of_num_blocks; // Number of blocks -> index in `fits`
+
+  auto fit_candidates = [&](const Int_Vec& candidates, const int round) {
+    std::vector<Block_Count_Fit> new_fits(candidates.size());
+
+    run_in_parallel(candidates.size(), num_threads, [&](const int candidate_i) {
+      Block_Count_Fit& fit = new_fits[candidate_i];
+      fit.num_blocks = candidates[candidate_i];
+      fit.round = round;
+
+      // Closest earlier fit, preferring more blocks on ties
+      const Block_Count_Fit* closest = nullptr;
+      for (const auto& fitted : fit_of_num_blocks) {
+        const Block_Count_Fit& other = selection.fits[fitted.second];
+        if (closest == nullptr ||
+            std::abs(other.num_blocks - fit.num_blocks) <= std::abs(closest->num_blocks - fit.num_blocks)) {
+          closest = &other;
+        }
+      }
+
+      const Random_Engine engine = chain_random_engine(seed, fit.num_blocks);
+      std::unique_ptr<SBM> sbm;
+      if (closest == nullptr) {
+        sbm.reset(new SBM(network, edges, fit.num_blocks, engine, sweep_order, block_init));
+      } else {
+        fit.warm_start_from = closest->num_blocks;
+        sbm.reset(new SBM(network, edges, fit.num_blocks,
+                          warm_start_positions(network, edges, closest->block_positions,
+                                               closest->num_blocks, fit.num_blocks),
+                          engine, sweep_order));
+      }
+
+      for (int i = 0; i < num_sweeps; i++) sbm->mcmc_sweep(eps, 1.0);
+
+      fit.entropy = sbm->entropy();
+      fit.description_length =
+          fit.entropy + model_description_length(network, edges, fit.num_blocks);
+      fit.block_positions = block_positions(sbm->get_blocks(), network.size());
+    });
+
+    for (auto& fit : new_fits) {
+      fit_of_num_blocks[fit.num_blocks] = selection.fits.size();
+      selection.fits.push_back(std::move(fit));
+    }
+  };
+
+  // Evenly spaced values strictly inside (lo, hi) that haven't been fitted yet, or all
+  // of them if there are few enough
+  auto candidates_between = [&](const int lo, const int hi) {
+    Int_Vec candidates;
+    const int num_inside = hi - lo - 1;
+    const int num_points = std::min(num_inside, candidates_per_round);
+    for (int i = 1; i <= num_points; i++) {
+      const int num_blocks = lo + int(std::round(double(hi - lo) * i / (num_points + 1)));
+      if (fit_of_num_blocks.count(num_blocks) == 0 &&
+          (candidates.empty() || candidates.back() != num_blocks)) {
+        candidates.push_back(num_blocks);
+      }
+    }
+    return candidates;
+  };
+
+  int lo = min_blocks;
+  int hi = max_blocks;
+
+  Int_Vec candidates = candidates_between(lo, hi);
+  candidates.insert(candidates.begin(), lo);
+  if (hi != lo) candidates.push_back(hi);
+
+  for (int round = 0; !candidates.empty(); round++) {
+    fit_candidates(candidates, round);
+
+    // Best fit in the bracket and the fitted values either side of it
+    int best = -1;
+    for (const auto& fitted : fit_of_num_blocks) {
+      if (fitted.first < lo || fitted.first > hi) continue;
+      if (best == -1 ||
+          selection.fits[fitted.second].description_length <
+              selection.fits[fit_of_num_blocks[best]].description_length) {
+        best = fitted.first;
+      }
+    }
+
+    auto best_it = fit_of_num_blocks.find(best);
+    lo = best_it == fit_of_num_blocks.begin() || std::prev(best_it)->first < lo
+             ? best : std::prev(best_it)->first;
+    hi = std::next(best_it) == fit_of_num_blocks.end() || std::next(best_it)->first > hi
+             ? best : std::next(best_it)->first;
+
+    candidates = candidates_between(lo, hi);
+  }
+
+  for (int fit_i = 1; fit_i < selection.fits.size(); fit_i++) {
+    if (selection.fits[fit_i].description_length <
+        selection.fits[selection.best_fit].description_length) {
+      selection.best_fit = fit_i;
+    }
+  }
+
+  return selection;
+}
+
+#endif
@@ -0,0 +1,210 @@
+#include <testthat.h>
+#include "rcpp_adapter.h"
+#include "Edge_Container.h"
+#include "swap_blocks.h"
+#include <random>
+
+// Every pair of blocks should have the same count as walking the children's edges does
+bool counts_match_children(const Node_Container& blocks) {
+  const Block_Edge_Counts& counts = blocks.get_edge_counts();
+
+  for (const auto& blocks_of_type : blocks.nodes) {
+    for (const auto& block : blocks_of_type) {
+      const Node_Edge_Counts from_children = block->get_block_edge_counts();
+
+      int num_in_row = 0;
+      bool row_matches = true;
+      counts.for_each_in_row(block.get(), [&](Node* other, const int count) {
+        num_in_row++;
+        const auto child_count = from_children.find(other);
+        if (child_count == from_children.end() || child_count->second != count) row_matches = false;
+      });
+
+      if (!row_matches || num_in_row != from_children.size()) return false;
+      for (const auto& child_count : from_children) {
+        if (counts.get(block.get(), child_count.first) != child_count.second) return false;
+      }
+    }
+  }
+  return true;
+}
+
+// Blocks sampled from each row turn up about as often as their share of the row
+bool samples_follow_counts(const Node_Container& blocks, Random_Engine& random_engine) {
+  const Block_Edge_Counts& counts = blocks.get_edge_counts();
+  const int num_samples = 4000;
+
+  for (const auto& blocks_of_type : blocks.nodes) {
+    for (const auto& block : blocks_of_type) {
+      const int degree = block->get_degree_to_type(0);
+      Node_Edge_Counts times_sampled;
+      for (int i = 0; i < num_samples; i++) {
+        Node* sampled = counts.sample_neighbor_block(block.get(), 0, random_engine);
+        if (sampled == nullptr) {
+          if (degree != 0) return false;
+          break;
+        }
+        times_sampled[sampled]++;
+      }
+
+      for (const auto& sampled : times_sampled) {
+        const double expected = double(counts.get(block.get(), sampled.first)) / degree;
+        if (expected == 0.0) return false;
+        if (std::abs(double(sampled.second) / num_samples - expected) > 0.05) return false;
+      }
+    }
+  }
+  return true;
+}
+
+context("Block edge counts") {
+  auto nodes_id   = Rcpp::CharacterVector{"n1", "n2", "n3", "n4", "n5", "n6", "n7", "n8"};
+  auto nodes_type = Rcpp::CharacterVector{ "a",  "a",  "a",  "a",  "a",  "a",  "a",  "a"};
+  auto types_name  = Rcpp::CharacterVector{"a"};
+  auto types_count = Rcpp::IntegerVector{    8};
+
+  // Includes a self edge on n4
+  const Rcpp::CharacterVector edges_from{"n1", "n1", "n2", "n3", "n4", "n4", "n5", "n6", "n7", "n8"};
+  const Rcpp::CharacterVector   edges_to{"n2", "n3", "n3", "n4", "n4", "n5", "n6", "n7", "n8", "n5"};
+
+  auto nodes = Node_Container(nodes_id, nodes_type, types_name, types_count);
+  auto edges = Edge_Container(edges_from, edges_to, nodes_id, nodes);
+
+  // Shuffle nodes between blocks, letting blocks empty out, checking counts each move
+  auto random_swaps = [&](Node_Container& blocks, Random_Engine& random_engine) {
+    bool all_match = true;
+    for (int i = 0; i < 40; i++) {
+      Node* node = nodes.at(0, i % nodes.size());
+      Node* new_block = get_random_element(blocks.get_nodes_of_type(0), random_engine).get();
+      swap_block(node, new_block, blocks, i % 3 == 0);
+      all_match = all_match && counts_match_children(blocks);
+    }
+    return all_match;
+  };
+
+  test_that("Starts out matching the children's edges") {
+    Random_Engine random_engine{};
+    random_engine.seed(42);
+    auto blocks = Node_Container(4, nodes, random_engine);
+
+    expect_true(blocks.get_edge_counts().is_dense());
+    expect_true(blocks.get_edge_counts().size() == 4);
+    expect_true(counts_match_children(blocks));
+  }
+
+  test_that("Dense counts follow moves and removed blocks") {
+    Random_Engine random_engine{};
+    random_engine.seed(42);
+    auto blocks = Node_Container(6, nodes, random_engine);
+
+    expect_true(random_swaps(blocks, random_engine));
+    expect_true(blocks.get_edge_counts().is_dense());
+    expect_true(blocks.get_edge_counts().size() == blocks.size());
+  }
+
+  test_that("Sparse counts follow moves and removed blocks") {
+    Random_Engine random_engine{};
+    random_engine.seed(42);
+    auto blocks = Node_Container(6, nodes, random_engine);
+    blocks.get_edge_counts().set_max_dense_bytes(0);
+
+    expect_false(blocks.get_edge_counts().is_dense());
+    expect_true(random_swaps(blocks, random_engine));
+    expect_true(blocks.get_edge_counts().size() == blocks.size());
+  }
+
+  test_that("Switches to dense once few enough blocks are left") {
+    Random_Engine random_engine{};
+    random_engine.seed(42);
+    auto blocks = Node_Container(8, nodes, random_engine);
+
+    // Room for a 6 x 6 matrix and its trees but not 8 x 8
+    blocks.get_edge_counts().set_max_dense_bytes(2 * 6 * 6 * sizeof(int));
+    expect_false(blocks.get_edge_counts().is_dense());
+
+    Node* target = blocks.at(0, 0);
+    int i = 0;
+    while (blocks.size() > 6) {
+      Node* node = nodes.at(0, i++);
+      if (node->get_parent() != target) swap_block(node, target, blocks, true);
+    }
+
+    expect_true(blocks.get_edge_counts().is_dense());
+    expect_true(counts_match_children(blocks));
+    expect_true(random_swaps(blocks, random_engine));
+  }
+
+  test_that("Sampled neighbor blocks follow the counts as blocks change") {
+    Random_Engine random_engine{};
+    random_engine.seed(42);
+    auto dense_blocks = Node_Container(4, nodes, random_engine);
+    expect_true(samples_follow_counts(dense_blocks, random_engine));
+    random_swaps(dense_blocks, random_engine);
+    expect_true(dense_blocks.get_edge_counts().is_dense());
+    expect_true(samples_follow_counts(dense_blocks, random_engine));
+
+    auto sparse_blocks = Node_Container(4, nodes, random_engine);
+    sparse_blocks.get_edge_counts().set_max_dense_bytes(0);
+    random_swaps(sparse_blocks, random_engine);
+    expect_true(samples_follow_counts(sparse_blocks, random_engine));
+  }
+}
+
+context("Block edge counts between types") {
+  auto nodes_id   = Rcpp::CharacterVector{"a1", "a2", "a3", "a4", "a5", "a6", "b1", "b2", "b3", "b4"};
+  auto nodes_type = Rcpp::CharacterVector{ "a",  "a",  "a",  "a",  "a",  "a",  "b",  "b",  "b",  "b"};
+  auto types_name  = Rcpp::CharacterVector{"a", "b"};
+  auto types_count = Rcpp::IntegerVector{    6,   4};
+
+  const Rcpp::CharacterVector edges_from{"a1", "a1", "a2", "a3", "a4", "a4", "a5", "a6", "a6"};
+  const Rcpp::CharacterVector   edges_to{"b1", "b2", "b2", "b3", "b3", "b4", "b1", "b4", "b2"};
+
+  auto nodes = Node_Container(nodes_id, nodes_type, types_name, types_count);
+  auto edges = Edge_Container(edges_from, edges_to, nodes_id, nodes);
+
+  test_that("Dense matrix only holds pairs of types with edges between them") {
+    Random_Engine random_engine(42);
+    auto blocks = Node_Container(3, nodes, random_engine);
+    const Block_Edge_Counts& counts = blocks.get_edge_counts();
+
+    expect_true(counts.is_dense());
+    expect_true(counts.memory_usage().bytes_of("dense_counts") == 2 * 3 * 3 * sizeof(int));
+    expect_true(counts_match_children(blocks));
+    expect_true(counts.get(blocks.at(0, 0), blocks.at(0, 1)) == 0);
+    expect_true(counts.sample_neighbor_block(blocks.at(0, 0), 0, random_engine) == nullptr);
+  }
+
+  test_that("Goes dense on the size of the cross type pairs") {
+    Random_Engine random_engine(42);
+    auto blocks = Node_Container(3, nodes, random_engine);
+
+    // Room for the two 3 x 3 halves and their trees but not a 6 x 6 matrix
+    blocks.get_edge_counts().set_max_dense_bytes(2 * 2 * 3 * 3 * sizeof(int));
+    expect_true(blocks.get_edge_counts().is_dense());
+    blocks.get_edge_counts().set_max_dense_bytes(2 * 2 * 3 * 3 * sizeof(int) - 1);
+    expect_false(blocks.get_edge_counts().is_dense());
+  }
+
+  test_that("Dense and sparse counts follow moves across both types") {
+    Random_Engine random_engine(7);
+    auto dense_nodes = nodes.clone();
+    auto sparse_nodes = nodes.clone();
+    auto dense_blocks = Node_Container(3, dense_nodes, random_engine);
+    auto sparse_blocks = Node_Container(3, sparse_nodes, random_engine);
+    sparse_blocks.get_edge_counts().set_max_dense_bytes(0);
+
+    bool all_match = true;
+    for (auto* blocks : {&dense_blocks, &sparse_blocks}) {
+      Node_Container& children = blocks == &dense_blocks ? dense_nodes : sparse_nodes;
+      for (int i = 0; i < 30; i++) {
+        const int type_i = i % 2;
+        Node* node = children.at(type_i, i % children.size_of_type(type_i));
+        Node* new_block = get_random_element(blocks->get_nodes_of_type(type_i), random_engine).get();
+        swap_block(node, new_block, *blocks, i % 4 == 0);
+        all_match = all_match && counts_match_children(*blocks);
+      }
+    }
+    expect_true(all_match);
+    expect_true(dense_blocks.get_edge_counts().is_dense());
+  }
+}
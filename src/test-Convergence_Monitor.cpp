@@ -0,0 +1,76 @@
+#include <testthat.h>
+#include "rcpp_adapter.h"
+#include "run_chains.h"
+
+context("Convergence monitoring") {
+  test_that("Flat series converge once the window fills") {
+    for (const auto test : {Convergence_Test::slope, Convergence_Test::geweke}) {
+      Convergence_Monitor monitor(Convergence_Settings(test, 20, 1e-3));
+
+      int sweeps_to_converge = 0;
+      while (!monitor.add_sweep(100.0 + 0.01 * (sweeps_to_converge % 2), 0.3)) sweeps_to_converge++;
+
+      expect_true(sweeps_to_converge == 19);
+      expect_true(monitor.stop_reason() == Stop_Reason::converged);
+    }
+  }
+
+  test_that("Steadily falling entropy never converges") {
+    for (const auto test : {Convergence_Test::slope, Convergence_Test::geweke}) {
+      Convergence_Monitor monitor(Convergence_Settings(test, 20, 1e-3));
+
+      bool converged = false;
+      for (int i = 0; i < 200; i++) converged = converged || monitor.add_sweep(1000.0 - i, 0.3);
+
+      expect_false(converged);
+      expect_true(monitor.stop_reason() == Stop_Reason::max_sweeps);
+    }
+  }
+
+  test_that("Drifting acceptance rate holds off convergence") {
+    Convergence_Monitor monitor(Convergence_Settings(Convergence_Test::slope, 20, 1e-3));
+
+    bool converged = false;
+    for (int i = 0; i < 40; i++) converged = converged || monitor.add_sweep(100.0, 0.9 - 0.02 * i);
+
+    expect_false(converged);
+  }
+
+  test_that("No test means no early stop") {
+    Convergence_Monitor monitor{Convergence_Settings()};
+    for (int i = 0; i < 100; i++) expect_false(monitor.add_sweep(100.0, 0.3));
+  }
+
+  test_that("Bad settings are caught") {
+    expect_error(Convergence_Settings("wobble", 50, 1e-3));
+    expect_error(Convergence_Settings("slope", 5, 1e-3));
+    expect_error(Convergence_Settings("geweke", 50, -1.0));
+  }
+}
+
+
+context("Chains stopping early") {
+  auto nodes_id   = Rcpp::CharacterVector{"a1", "a2", "a3", "a4", "b1", "b2", "b3", "b4"};
+  auto nodes_type = Rcpp::CharacterVector{ "a",  "a",  "a",  "a",  "b",  "b",  "b",  "b"};
+  auto types_name  = Rcpp::CharacterVector{"a", "b"};
+  auto types_count = Rcpp::IntegerVector{    4,   4};
+
+  const Rcpp::CharacterVector edges_from{"a1", "a2", "a2", "a3", "a3", "a3", "a4", "a4"};
+  const Rcpp::CharacterVector   edges_to{"b2", "b1", "b2", "b1", "b2", "b4", "b3", "b4"};
+
+  auto nodes = Node_Container(nodes_id, nodes_type, types_name, types_count);
+  auto edges = Edge_Container(edges_from, edges_to, nodes_id, nodes);
+
+  const auto results = run_chains(nodes, edges, 2, 500, 2, 42, 0.1, 1, Beta_Schedule(),
+                                  Sweep_Order::fixed, Block_Init::random,
+                                  Convergence_Settings("geweke", 20, 1e-3));
+
+  test_that("Stationary chains stop before running out of sweeps") {
+    for (const auto& chain : results.chains) {
+      expect_true(chain.stop_reason == Stop_Reason::converged);
+      expect_true(chain.num_sweeps() < 500);
+      expect_true(chain.num_sweeps() >= 20);
+      expect_true(chain.entropy_trace.size() == chain.num_sweeps() + 1);
+    }
+  }
+}
@@ -1,4 +1,5 @@
 #include <testthat.h>
+#include "rcpp_adapter.h"
 #include "Edge_Container.h"
 
 // Initialize a unit test context. This is similar to how you
@@ -264,3 +265,77 @@ context("Fully connected tripartite network") {
   }
 
 }
+
+
+context("Building edges across several threads") {
+  // Enough edges to span a few chunks, including repeats and self loops
+  const int num_nodes = 3000;
+  const int num_edges = 150000;
+
+  Rcpp::CharacterVector nodes_id(num_nodes);
+  Rcpp::CharacterVector nodes_type(num_nodes);
+  for (int i = 0; i < num_nodes; i++) {
+    nodes_id[i] = "n" + std::to_string(i);
+    nodes_type[i] = "a";
+  }
+  const auto types_name = Rcpp::CharacterVector{"a"};
+  const auto types_count = Rcpp::IntegerVector{num_nodes};
+
+  std::mt19937 random_engine(42);
+  std::uniform_int_distribution<int> random_node(0, num_nodes - 1);
+  Rcpp::CharacterVector edges_from(num_edges);
+  Rcpp::CharacterVector edges_to(num_edges);
+  for (int i = 0; i < num_edges; i++) {
+    edges_from[i] = nodes_id[random_node(random_engine)];
+    edges_to[i] = i % 1000 == 0 ? edges_from[i] : nodes_id[random_node(random_engine)];
+  }
+
+  auto serial_nodes = Node_Container(nodes_id, nodes_type, types_name, types_count);
+  auto threaded_nodes = Node_Container(nodes_id, nodes_type, types_name, types_count);
+  auto serial = Edge_Container(edges_from, edges_to, nodes_id, serial_nodes, {}, {}, 1);
+  auto threaded = Edge_Container(edges_from, edges_to, nodes_id, threaded_nodes, {}, {}, 4);
+
+  test_that("Nodes get their edges in input order whatever the thread count") {
+    // What adding the edges one at a time would give
+    std::vector<std::vector<int>> expected(num_nodes);
+    auto node_by_id = serial_nodes.get_id_to_node_map(nodes_id);
+    for (int i = 0; i < num_edges; i++) {
+      const int from = node_by_id.at(std::string(edges_from[i]))->index;
+      const int to = node_by_id.at(std::string(edges_to[i]))->index;
+      expected[from].push_back(to);
+      expected[to].push_back(from);
+    }
+
+    bool serial_matches = true;
+    bool threaded_matches = true;
+    for (int i = 0; i < num_nodes; i++) {
+      std::vector<int> serial_edges, threaded_edges;
+      for (const Node* neighbor : serial_nodes.at(0, i)->get_edges_to_type(0)) serial_edges.push_back(neighbor->index);
+      for (const Node* neighbor : threaded_nodes.at(0, i)->get_edges_to_type(0)) threaded_edges.push_back(neighbor->index);
+
+      serial_matches = serial_matches && serial_edges == expected[i] &&
+                       serial_nodes.at(0, i)->get_degree() == expected[i].size();
+      threaded_matches = threaded_matches && threaded_edges == expected[i] &&
+                         threaded_nodes.at(0, i)->get_degree() == expected[i].size();
+    }
+    expect_true(serial_matches);
+    expect_true(threaded_matches);
+    expect_true(threaded.size() == num_edges);
+    expect_true(threaded.data()[1234].first()->index == serial.data()[1234].first()->index);
+  }
+
+  test_that("The first bad edge is the one reported") {
+    Rcpp::CharacterVector bad_to = Rcpp::clone(edges_to);
+    bad_to[140000] = "missing_late";
+    bad_to[70000] = "missing_early";
+
+    auto nodes = Node_Container(nodes_id, nodes_type, types_name, types_count);
+    std::string message;
+    try {
+      Edge_Container(edges_from, bad_to, nodes_id, nodes, {}, {}, 4);
+    } catch (const std::exception& e) {
+      message = e.what();
+    }
+    expect_true(message.find("missing_early") != std::string::npos);
+  }
+}
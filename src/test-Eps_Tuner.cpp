@@ -0,0 +1,103 @@
+#include <testthat.h>
+#include "rcpp_adapter.h"
+#include "run_chains.h"
+
+context("Tuning eps per node type") {
+  test_that("Eps follows each type's acceptance rate") {
+    Eps_Tuner tuner(3, 0.1, Eps_Tuning(10, 0.2));
+
+    // Type 0 accepts too much, type 1 too little and type 2 never proposes anything
+    tuner.update({100, 100, 0}, {60, 1, 0});
+
+    const Double_Vec& eps = tuner.get_eps();
+    expect_true(eps[0] > 0.1);
+    expect_true(eps[1] < 0.1);
+    expect_true(eps[2] == 0.1);
+  }
+
+  test_that("Eps is frozen after burn-in") {
+    Eps_Tuner tuner(1, 0.1, Eps_Tuning(3, 0.2));
+    for (int i = 0; i < 3; i++) {
+      expect_false(tuner.is_frozen());
+      tuner.update({100}, {1});
+    }
+    expect_true(tuner.is_frozen());
+
+    const double frozen_eps = tuner.get_eps()[0];
+    tuner.update({100}, {1});
+    expect_true(tuner.get_eps()[0] == frozen_eps);
+  }
+
+  test_that("Eps stays within bounds however skewed the rates") {
+    Eps_Tuner tuner(2, 0.1, Eps_Tuning(500, 0.2));
+    for (int i = 0; i < 500; i++) tuner.update({10, 10}, {10, 0});
+
+    expect_true(tuner.get_eps()[0] <= 1e3);
+    expect_true(tuner.get_eps()[1] >= 1e-3);
+  }
+
+  test_that("Without tuning eps is left as given") {
+    Eps_Tuner tuner(2, 0.1);
+    expect_true(tuner.is_frozen());
+    tuner.update({10, 10}, {10, 0});
+    expect_true(tuner.get_eps() == Double_Vec({0.1, 0.1}));
+  }
+
+  test_that("Bad settings are caught") {
+    expect_error(Eps_Tuning(-1, 0.2));
+    expect_error(Eps_Tuning(10, 0.0));
+    expect_error(Eps_Tuning(10, 1.0));
+    expect_error(Eps_Tuner(1, 0.0, Eps_Tuning(10, 0.2)));
+  }
+}
+
+context("Chains with tuned eps") {
+  auto nodes_id   = Rcpp::CharacterVector{"a1", "a2", "a3", "a4", "a5", "a6", "b1", "b2", "b3"};
+  auto nodes_type = Rcpp::CharacterVector{ "a",  "a",  "a",  "a",  "a",  "a",  "b",  "b",  "b"};
+  auto types_name  = Rcpp::CharacterVector{"a", "b"};
+  auto types_count = Rcpp::IntegerVector{    6,   3};
+
+  const Rcpp::CharacterVector edges_from{"a1", "a1", "a2", "a3", "a3", "a4", "a5", "a5", "a6", "a6"};
+  const Rcpp::CharacterVector   edges_to{"b1", "b2", "b1", "b2", "b3", "b3", "b1", "b3", "b2", "b3"};
+
+  auto nodes = Node_Container(nodes_id, nodes_type, types_name, types_count);
+  auto edges = Edge_Container(edges_from, edges_to, nodes_id, nodes);
+
+  test_that("A sweep with the same eps for every type matches a single eps") {
+    SBM single(nodes, edges, 2, Random_Engine(3));
+    SBM by_type(nodes, edges, 2, Random_Engine(3));
+
+    for (int i = 0; i < 10; i++) {
+      const Sweep_Results a = single.mcmc_sweep(0.3, 1.0);
+      const Sweep_Results b = by_type.mcmc_sweep(Double_Vec{0.3, 0.3}, 1.0);
+      expect_true(a.entropy_delta == b.entropy_delta);
+      expect_true(a.proposed_by_type == b.proposed_by_type);
+      expect_true(a.moved_by_type == b.moved_by_type);
+    }
+    expect_true(single.block_assignments() == by_type.block_assignments());
+  }
+
+  test_that("Sweeps count proposals and moves by type") {
+    SBM sbm(nodes, edges, 2, Random_Engine(8));
+    const Sweep_Results sweep = sbm.mcmc_sweep(Double_Vec{0.5, 0.05}, 1.0);
+
+    expect_true(sweep.proposed_by_type.size() == 2);
+    expect_true(sweep.moved_by_type[0] + sweep.moved_by_type[1] == sweep.num_nodes_moved);
+    expect_true(sweep.moved_by_type[0] <= sweep.proposed_by_type[0]);
+    expect_true(sweep.proposed_by_type[1] <= 3);
+  }
+
+  test_that("Chains report the eps they settled on") {
+    const auto fixed = run_chains(nodes, edges, 2, 30, 2, 42, 0.1, 1);
+    const auto tuned = run_chains(nodes, edges, 2, 30, 2, 42, 0.1, 2, Beta_Schedule(),
+                                  Sweep_Order::fixed, Block_Init::random,
+                                  Convergence_Settings(), Eps_Tuning(20, 0.2));
+
+    for (int chain_i = 0; chain_i < 2; chain_i++) {
+      expect_true(fixed.chains[chain_i].eps_by_type == Double_Vec({0.1, 0.1}));
+      expect_true(tuned.chains[chain_i].eps_by_type.size() == 2);
+      expect_true(tuned.chains[chain_i].eps_by_type != Double_Vec({0.1, 0.1}));
+      expect_true(tuned.chains[chain_i].entropy_trace.size() == 31);
+    }
+  }
+}
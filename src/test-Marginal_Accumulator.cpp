@@ -0,0 +1,86 @@
+#include <testthat.h>
+#include "rcpp_adapter.h"
+#include "Marginal_Accumulator.h"
+#include "SBM_Model.h"
+
+context("Accumulating block marginals") {
+  auto nodes_id   = Rcpp::CharacterVector{"n1", "n2", "n3", "n4", "n5", "n6", "n7", "n8"};
+  auto nodes_type = Rcpp::CharacterVector{ "a",  "a",  "a",  "a",  "a",  "a",  "a",  "a"};
+  auto types_name  = Rcpp::CharacterVector{"a"};
+  auto types_count = Rcpp::IntegerVector{    8};
+
+  const Rcpp::CharacterVector edges_from{"n1", "n1", "n2", "n3", "n4", "n5", "n5", "n6", "n7", "n8"};
+  const Rcpp::CharacterVector   edges_to{"n2", "n3", "n3", "n4", "n5", "n6", "n7", "n7", "n8", "n1"};
+
+  auto nodes = Node_Container(nodes_id, nodes_type, types_name, types_count);
+  auto edges = Edge_Container(edges_from, edges_to, nodes_id, nodes);
+
+  const int num_blocks = 3;
+  const int num_sweeps = 60;
+  const Int_Vec subset{1, 4, 6, 7};
+
+  // Run a hot chain so plenty of nodes move, tallying every sweep the slow way as well
+  SBM sbm(nodes, edges, num_blocks, Random_Engine(3));
+  Marginal_Accumulator accumulator(sbm.get_nodes(), subset);
+
+  Double_Vec brute_blocks(nodes.size() * num_blocks, 0.0);
+  Double_Vec brute_pairs(subset.size() * subset.size(), 0.0);
+
+  for (int i = 0; i < num_sweeps; i++) {
+    accumulator.record_sweep(sbm.mcmc_sweep(0.5, 0.2).moved_nodes);
+
+    const Int_Vec assignments = sbm.block_assignments();
+    for (int node_i = 0; node_i < nodes.size(); node_i++) {
+      brute_blocks[assignments[node_i] * nodes.size() + node_i] += 1.0 / num_sweeps;
+    }
+    for (int a = 0; a < subset.size(); a++) {
+      for (int b = 0; b < subset.size(); b++) {
+        if (assignments[subset[a]] == assignments[subset[b]]) {
+          brute_pairs[a * subset.size() + b] += 1.0 / num_sweeps;
+        }
+      }
+    }
+  }
+
+  auto all_close = [](const Double_Vec& a, const Double_Vec& b) {
+    if (a.size() != b.size()) return false;
+    for (int i = 0; i < a.size(); i++) {
+      if (std::abs(a[i] - b[i]) > 1e-9) return false;
+    }
+    return true;
+  };
+
+  test_that("Block histograms match tallying every node every sweep") {
+    expect_true(accumulator.get_num_samples() == num_sweeps);
+    expect_true(all_close(accumulator.block_marginals(num_blocks), brute_blocks));
+  }
+
+  test_that("Pair co-occurrence matches tallying every pair every sweep") {
+    expect_true(accumulator.subset_size() == 4);
+    expect_true(all_close(accumulator.co_occurrence(), brute_pairs));
+  }
+
+  test_that("Each node's block proportions sum to one") {
+    const Double_Vec marginals = accumulator.block_marginals(num_blocks);
+    for (int node_i = 0; node_i < nodes.size(); node_i++) {
+      double total = 0.0;
+      for (int block_i = 0; block_i < num_blocks; block_i++) {
+        total += marginals[block_i * nodes.size() + node_i];
+      }
+      expect_true(std::abs(total - 1.0) < 1e-9);
+    }
+  }
+
+  test_that("Models only tally once asked to") {
+    SBM_Model model(nodes_id, nodes_type, types_name, types_count, edges_from, edges_to, 2);
+    expect_error(model.get_marginals());
+
+    model.run_sweeps(5);
+    model.start_marginals({0, 2});
+    model.run_sweeps(10);
+
+    expect_true(model.get_marginals().get_num_samples() == 10);
+    expect_true(model.num_block_columns() == 2);
+    expect_error(model.start_marginals({8}));
+  }
+}
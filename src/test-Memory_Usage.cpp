@@ -0,0 +1,141 @@
+#include <testthat.h>
+#include "rcpp_adapter.h"
+#include "SBM_Model.h"
+
+context("Memory usage bookkeeping") {
+  test_that("Parts with the same name are merged") {
+    Memory_Usage usage;
+    usage.add("a", 10, 1);
+    usage.add("b", 5, 2);
+    usage.add("a", 20, 1);
+
+    expect_true(usage.get_parts().size() == 2);
+    expect_true(usage.bytes_of("a") == 30);
+    expect_true(usage.bytes_of("missing") == 0);
+    expect_true(usage.total_bytes() == 35);
+    expect_true(usage.total_allocations() == 4);
+
+    Memory_Usage outer;
+    outer.add("inner", usage);
+    expect_true(outer.bytes_of("inner_a") == 30);
+    expect_true(outer.total_allocations() == 4);
+  }
+
+  test_that("Vectors are counted by capacity") {
+    std::vector<double> values;
+    Memory_Usage usage;
+    usage.add_vector("empty", values);
+
+    values.reserve(100);
+    values.push_back(1.0);
+    usage.add_vector("values", values);
+
+    expect_true(usage.bytes_of("empty") == 0);
+    expect_true(usage.bytes_of("values") == values.capacity() * sizeof(double));
+    expect_true(usage.total_allocations() == 1);
+  }
+
+  test_that("Only long strings count heap bytes") {
+    expect_true(string_heap_bytes(std::string("a")) == 0);
+    const std::string long_string(200, 'x');
+    expect_true(string_heap_bytes(long_string) > 200);
+  }
+}
+
+context("Memory usage of containers") {
+  const Rcpp::CharacterVector nodes_id{"a1", "a2", "a3", "a4", "a5", "a6"};
+  const Rcpp::CharacterVector nodes_type{"a", "a", "a", "a", "a", "a"};
+  const Rcpp::CharacterVector types_name{"a"};
+  const Rcpp::IntegerVector types_count{6};
+
+  const Rcpp::CharacterVector edges_from{"a1", "a1", "a2", "a3", "a4", "a5", "a6"};
+  const Rcpp::CharacterVector   edges_to{"a2", "a3", "a3", "a4", "a5", "a6", "a4"};
+
+  auto nodes = Node_Container(nodes_id, nodes_type, types_name, types_count);
+  auto edges = Edge_Container(edges_from, edges_to, nodes_id, nodes);
+
+  test_that("Network nodes count their edges but no children") {
+    const Memory_Usage usage = nodes.memory_usage();
+
+    expect_true(usage.bytes_of("node_objects") == 6 * sizeof(Node));
+    // Edges are sized exactly: two ends per edge plus a per type vector for each node
+    expect_true(usage.bytes_of("edge_vectors") ==
+                2 * 7 * sizeof(Node*) + 6 * sizeof(Node_Ptrs));
+    expect_true(usage.bytes_of("child_lists") == 0);
+    expect_true(usage.bytes_of("edge_counts_dense_counts") == 0);
+    expect_true(usage.bytes_of("type_map") > 0);
+  }
+
+  test_that("Blocks count their children and edge counts") {
+    Random_Engine random_engine(42);
+    auto blocks = Node_Container(2, nodes, random_engine);
+    const Memory_Usage usage = blocks.memory_usage();
+
+    expect_true(usage.bytes_of("node_objects") == 2 * sizeof(Node));
+    expect_true(usage.bytes_of("child_lists") >= 6 * sizeof(Node*));
+    expect_true(blocks.get_edge_counts().is_dense());
+    expect_true(usage.bytes_of("edge_counts_dense_counts") >= 2 * 2 * sizeof(int));
+    expect_true(usage.bytes_of("edge_counts_fenwick_trees") >= 2 * 2 * sizeof(int));
+
+    // Moving to sparse rows trades the matrix for hash rows
+    blocks.get_edge_counts().set_max_dense_bytes(0);
+    const Memory_Usage sparse_usage = blocks.memory_usage();
+    expect_true(sparse_usage.bytes_of("edge_counts_dense_counts") == 0);
+    expect_true(sparse_usage.bytes_of("edge_counts_sparse_rows") > 0);
+  }
+
+  test_that("Edges count their pairs") {
+    const Memory_Usage usage = edges.memory_usage();
+    expect_true(usage.bytes_of("edge_pairs") == 7 * sizeof(Ordered_Pair<Node*>));
+    expect_true(usage.bytes_of("neighbor_types") > 0);
+  }
+
+  test_that("Id lookups only hold a content map once they've needed one") {
+    Id_Lookup id_lookup = nodes.get_id_lookup(nodes_id);
+    expect_true(id_lookup.memory_usage().bytes_of("by_content") == 0);
+
+    id_lookup.find(std::string("a3"));
+    expect_true(id_lookup.memory_usage().bytes_of("by_content") > 0);
+
+    const Id_to_Node_Map id_map = nodes.get_id_to_node_map(nodes_id);
+    Memory_Usage map_usage;
+    add_map(map_usage, "id_map", id_map);
+    expect_true(map_usage.total_allocations() >= 6);
+  }
+}
+
+context("Memory usage of a model") {
+  const Rcpp::CharacterVector nodes_id{"a1", "a2", "a3", "a4", "b1", "b2", "b3"};
+  const Rcpp::CharacterVector nodes_type{"a", "a", "a", "a", "b", "b", "b"};
+  const Rcpp::CharacterVector types_name{"a", "b"};
+  const Rcpp::IntegerVector types_count{4, 3};
+
+  const Rcpp::CharacterVector edges_from{"a1", "a1", "a2", "a3", "a4", "a4"};
+  const Rcpp::CharacterVector   edges_to{"b1", "b2", "b2", "b3", "b1", "b3"};
+
+  test_that("Covers the chain's nodes and caches as well as the network") {
+    SBM_Model model(nodes_id, nodes_type, types_name, types_count, edges_from, edges_to, 2);
+    model.run_sweeps(3);
+
+    size_t network_node_bytes = 0;
+    size_t total_bytes = 0;
+    std::vector<string> names;
+    for (const auto& structure : model.memory_usage()) {
+      names.push_back(structure.first);
+      total_bytes += structure.second.total_bytes();
+      if (structure.first == "nodes") network_node_bytes = structure.second.total_bytes();
+    }
+
+    expect_true(names == std::vector<string>({"nodes", "edges", "chain_nodes", "blocks",
+                                              "histograms", "move_cache", "scheduler"}));
+    expect_true(total_bytes >= 2 * network_node_bytes);
+
+    const auto usage = model.memory_usage();
+    expect_true(usage[2].second.bytes_of("node_objects") == usage[0].second.bytes_of("node_objects"));
+    expect_true(usage[5].second.bytes_of("entries") > 0);
+    expect_true(usage[4].second.bytes_of("histogram_counts") > 0);
+
+    model.start_marginals({0, 1});
+    expect_true(model.memory_usage().back().first == "marginals");
+  }
+}
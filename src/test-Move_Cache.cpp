@@ -0,0 +1,99 @@
+#include <testthat.h>
+#include "rcpp_adapter.h"
+#include "SBM.h"
+
+context("Memoized move scores") {
+  auto nodes_id   = Rcpp::CharacterVector{"n1", "n2", "n3", "n4", "n5", "n6", "n7", "n8", "n9"};
+  auto nodes_type = Rcpp::CharacterVector{ "a",  "a",  "a",  "a",  "a",  "a",  "a",  "a",  "a"};
+  auto types_name  = Rcpp::CharacterVector{"a"};
+  auto types_count = Rcpp::IntegerVector{    9};
+
+  // Includes a self edge on n4
+  const Rcpp::CharacterVector edges_from{"n1", "n1", "n2", "n3", "n4", "n4", "n5", "n6", "n7", "n8", "n9"};
+  const Rcpp::CharacterVector   edges_to{"n2", "n3", "n3", "n4", "n4", "n5", "n6", "n7", "n8", "n5", "n8"};
+
+  auto nodes = Node_Container(nodes_id, nodes_type, types_name, types_count);
+  auto edges = Edge_Container(edges_from, edges_to, nodes_id, nodes);
+  auto node_by_id = nodes.get_id_to_node_map(nodes_id);
+
+  test_that("Cached scores are dropped once anything they depend on changes") {
+    Random_Engine random_engine(42);
+    auto blocks = Node_Container(3, nodes, random_engine);
+    Neighbor_Histograms histograms(nodes.size());
+    Move_Cache move_cache(nodes.size());
+    const Move_Contexts contexts = build_move_contexts(blocks, edges, 0.3);
+
+    Node* n1 = node_by_id.at("n1");
+    Node* target = n1->get_parent() == blocks.at(0, 0) ? blocks.at(0, 1) : blocks.at(0, 0);
+
+    auto stamp_for = [&](Node* node, Node* new_block) {
+      return Move_Stamp(node, new_block, histograms.get(node), blocks.get_edge_counts());
+    };
+
+    const Move_Results scored = Move_Evaluator(n1, contexts[0]).evaluate(target);
+    move_cache.store(n1, target, stamp_for(n1, target), scored);
+
+    const Move_Results* cached = move_cache.find(n1, target, stamp_for(n1, target));
+    expect_true(cached != nullptr);
+    expect_true(cached->entropy_delta == scored.entropy_delta);
+    expect_true(move_cache.find(n1, n1->get_parent(), stamp_for(n1, n1->get_parent())) == nullptr);
+
+    // Moving any node in or out of the target block changes its row
+    Node* n9 = node_by_id.at("n9");
+    Node* n9_block = n9->get_parent();
+    swap_block(n9, n9_block == target ? n1->get_parent() : target, blocks, false);
+    expect_true(move_cache.find(n1, target, stamp_for(n1, target)) == nullptr);
+    swap_block(n9, n9_block, blocks, false);
+
+    expect_true(move_cache.get_num_lookups() == 3);
+    expect_true(move_cache.get_num_hits() == 1);
+
+    move_cache.store(n1, target, stamp_for(n1, target), scored);
+    move_cache.clear();
+    expect_true(move_cache.find(n1, target, stamp_for(n1, target)) == nullptr);
+  }
+
+  test_that("Hits always agree with scoring from scratch") {
+    Random_Engine random_engine(7);
+    auto blocks = Node_Container(3, nodes, random_engine);
+    Neighbor_Histograms histograms(nodes.size());
+    Move_Cache move_cache(nodes.size(), 2);
+    const Move_Contexts contexts = build_move_contexts(blocks, edges, 0.3);
+
+    bool all_agree = true;
+    for (int i = 0; i < 400; i++) {
+      Node* node = nodes.at(0, i % nodes.size());
+      Node* new_block = propose_move(node, blocks, random_engine, contexts[0]);
+      if (new_block == node->get_parent()) continue;
+
+      const Move_Stamp stamp(node, new_block, histograms.get(node), blocks.get_edge_counts());
+      const Move_Results fresh = Move_Evaluator(node, contexts[0]).evaluate(new_block);
+      const Move_Results* cached = move_cache.find(node, new_block, stamp);
+
+      if (cached == nullptr) {
+        move_cache.store(node, new_block, stamp, fresh);
+      } else {
+        all_agree = all_agree &&
+                    std::abs(cached->entropy_delta - fresh.entropy_delta) < 1e-10 &&
+                    std::abs(cached->prob_ratio - fresh.prob_ratio) < 1e-10;
+      }
+
+      // Move now and then so plenty of entries go stale
+      if (i % 7 == 0) swap_block(node, new_block, blocks, false);
+    }
+
+    expect_true(all_agree);
+    expect_true(move_cache.get_num_hits() > 0);
+    expect_true(move_cache.get_num_hits() < move_cache.get_num_lookups());
+  }
+
+  test_that("Chains report how often they reuse scores") {
+    SBM sbm(nodes, edges, 3, Random_Engine(5));
+    for (int i = 0; i < 50; i++) sbm.mcmc_sweep(0.1, 1.0);
+
+    const Move_Cache& move_cache = sbm.get_move_cache();
+    expect_true(move_cache.get_num_lookups() > 0);
+    expect_true(move_cache.hit_rate() > 0.0);
+    expect_true(move_cache.hit_rate() <= 1.0);
+  }
+}
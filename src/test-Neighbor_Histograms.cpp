@@ -0,0 +1,110 @@
+#include <testthat.h>
+#include "rcpp_adapter.h"
+#include "SBM.h"
+
+// Flat histogram holds the same counts as the map version
+bool histogram_matches_map(const Block_Histogram& histogram, Node* node) {
+  const Node_Edge_Counts from_map = node->get_block_edge_counts();
+  if (histogram.counts.size() != from_map.size()) return false;
+
+  auto map_count = from_map.begin();
+  for (const auto& count : histogram) {
+    if (count.first != map_count->first || count.second != map_count->second) return false;
+    map_count++;
+  }
+  return true;
+}
+
+context("Cached neighbor block histograms") {
+  auto nodes_id   = Rcpp::CharacterVector{"n1", "n2", "n3", "n4", "n5", "n6", "n7", "n8"};
+  auto nodes_type = Rcpp::CharacterVector{ "a",  "a",  "a",  "a",  "a",  "a",  "a",  "a"};
+  auto types_name  = Rcpp::CharacterVector{"a"};
+  auto types_count = Rcpp::IntegerVector{    8};
+
+  // Includes a self edge on n4 and a repeated n1-n2 edge
+  const Rcpp::CharacterVector edges_from{"n1", "n1", "n1", "n2", "n3", "n4", "n4", "n5", "n6", "n7", "n8"};
+  const Rcpp::CharacterVector   edges_to{"n2", "n2", "n3", "n3", "n4", "n4", "n5", "n6", "n7", "n8", "n5"};
+
+  auto nodes = Node_Container(nodes_id, nodes_type, types_name, types_count);
+  auto edges = Edge_Container(edges_from, edges_to, nodes_id, nodes);
+  auto node_by_id = nodes.get_id_to_node_map(nodes_id);
+
+  test_that("Histograms match the block edge counts") {
+    Random_Engine random_engine(42);
+    auto blocks = Node_Container(3, nodes, random_engine);
+
+    for (int i = 0; i < nodes.size(); i++) {
+      Node* node = nodes.at(0, i);
+      const Block_Histogram histogram(node);
+      expect_true(histogram_matches_map(histogram, node));
+      expect_true(histogram.self_edges == (node == node_by_id.at("n4") ? 2 : 0));
+    }
+  }
+
+  test_that("Only rebuilt once a neighbor has moved") {
+    Random_Engine random_engine(42);
+    auto blocks = Node_Container(3, nodes, random_engine);
+    Neighbor_Histograms histograms(nodes.size());
+
+    Node* n1 = node_by_id.at("n1");
+    Node* n6 = node_by_id.at("n6");
+    histograms.get(n1);
+    histograms.get(n1);
+    histograms.get(n6);
+    expect_true(histograms.get_num_builds() == 2);
+    expect_true(histograms.get_num_hits() == 1);
+
+    // n3 neighbors n1 but not n6
+    Node* n3 = node_by_id.at("n3");
+    Node* new_block = n3->get_parent() == blocks.at(0, 0) ? blocks.at(0, 1) : blocks.at(0, 0);
+    swap_block(n3, new_block, blocks, false);
+
+    expect_true(histogram_matches_map(histograms.get(n1), n1));
+    expect_true(histogram_matches_map(histograms.get(n6), n6));
+    expect_true(histograms.get_num_builds() == 3);
+    expect_true(histograms.get_num_hits() == 2);
+
+    // A node with a self edge goes stale when it moves itself
+    Node* n4 = node_by_id.at("n4");
+    histograms.get(n4);
+    swap_block(n4, n4->get_parent() == blocks.at(0, 2) ? blocks.at(0, 1) : blocks.at(0, 2), blocks, false);
+    expect_true(histogram_matches_map(histograms.get(n4), n4));
+  }
+
+  test_that("Stay in step with the blocks through a run of sweeps") {
+    SBM sbm(nodes, edges, 3, Random_Engine(5));
+    bool all_match = true;
+
+    for (int i = 0; i < 30; i++) {
+      sbm.mcmc_sweep(0.5, 0.2);
+
+      Neighbor_Histograms& histograms = sbm.get_histograms();
+      for (const auto& node : sbm.get_nodes().get_nodes_of_type(0)) {
+        all_match = all_match && histogram_matches_map(histograms.get(node.get()), node.get());
+      }
+    }
+
+    expect_true(all_match);
+    expect_true(sbm.get_histograms().get_num_hits() > 0);
+  }
+
+  test_that("Scoring from a cached histogram matches scoring from scratch") {
+    Random_Engine random_engine(42);
+    auto blocks = Node_Container(3, nodes, random_engine);
+    Neighbor_Histograms histograms(nodes.size());
+    const Move_Contexts contexts = build_move_contexts(blocks, edges, 0.3);
+
+    for (int i = 0; i < nodes.size(); i++) {
+      Node* node = nodes.at(0, i);
+      Move_Evaluator fresh(node, contexts[0]);
+      Move_Evaluator cached(node, contexts[0], histograms.get(node));
+
+      for (const auto& block : blocks.get_nodes_of_type(0)) {
+        const Move_Results a = fresh.evaluate(block.get());
+        const Move_Results b = cached.evaluate(block.get());
+        expect_true(a.entropy_delta == b.entropy_delta);
+        expect_true(a.prob_ratio == b.prob_ratio);
+      }
+    }
+  }
+}
@@ -10,6 +10,7 @@
 // All test files should include the <testthat.h>
 // header file.
 #include <testthat.h>
+#include "rcpp_adapter.h"
 #include "Node_Container.h"
 
 // Initialize a unit test context. This is similar to how you
@@ -0,0 +1,269 @@
+#include <testthat.h>
+#include "rcpp_adapter.h"
+#include "parallel_tempering.h"
+#include "select_num_blocks.h"
+
+void expect_near(const double a, const double b, const double thresh = 1e-8){
+  expect_true(std::abs(a - b) < thresh);
+}
+
+context("Cloning a network") {
+  auto nodes_id   = Rcpp::CharacterVector{"a1", "a2", "a3", "b1", "b2", "b3"};
+  auto nodes_type = Rcpp::CharacterVector{ "a",  "a",  "a",  "b",  "b",  "b"};
+  auto types_name  = Rcpp::CharacterVector{"a", "b"};
+  auto types_count = Rcpp::IntegerVector{    3,   3};
+
+  const Rcpp::CharacterVector edges_from{"a1", "a1", "a2", "a3", "a3"};
+  const Rcpp::CharacterVector   edges_to{"b1", "b2", "b2", "b2", "b3"};
+
+  auto nodes = Node_Container(nodes_id, nodes_type, types_name, types_count);
+  auto edges = Edge_Container(edges_from, edges_to, nodes_id, nodes);
+
+  auto copy = nodes.clone();
+
+  test_that("Copy has the same nodes and edges") {
+    expect_true(copy.size() == nodes.size());
+    expect_true(copy.size_of_type(1) == 3);
+
+    for (int type_i = 0; type_i < 2; type_i++) {
+      for (int i = 0; i < 3; i++) {
+        Node* original = nodes.at(type_i, i);
+        Node* copied = copy.at(type_i, i);
+
+        expect_true(copied != original);
+        expect_true(copied->index == original->index);
+        expect_true(copied->get_degree() == original->get_degree());
+      }
+    }
+  }
+
+  test_that("Copied edges point to copied nodes") {
+    Node* a1_copy = copy.at(0, 0);
+    for (const auto& neighbor : a1_copy->get_edges_to_type(1)) {
+      expect_true(neighbor == copy.at(1, 0) || neighbor == copy.at(1, 1));
+    }
+  }
+
+  test_that("Blocks built on copy leave original untouched") {
+    Random_Engine random_engine{};
+    random_engine.seed(42);
+    auto blocks = Node_Container(2, copy, random_engine);
+
+    expect_true(copy.at(0, 0)->get_parent() != nullptr);
+    expect_true(nodes.at(0, 0)->get_parent() == nullptr);
+  }
+}
+
+
+context("Entropy of full model agrees with move deltas") {
+  Random_Engine random_engine{};
+  random_engine.seed(42);
+
+  auto nodes_id   = Rcpp::CharacterVector{"n1", "n2", "n3", "n4", "n5", "n6"};
+  auto nodes_type = Rcpp::CharacterVector{ "a",  "a",  "a",  "a",  "a",  "a"};
+  auto types_name  = Rcpp::CharacterVector{"a"};
+  auto types_count = Rcpp::IntegerVector{    6};
+
+  const Rcpp::CharacterVector edges_from{"n1", "n1", "n1", "n1", "n2", "n2", "n2", "n3", "n3", "n4", "n4", "n5"};
+  const Rcpp::CharacterVector   edges_to{"n2", "n3", "n4", "n5", "n3", "n4", "n5", "n4", "n6", "n5", "n6", "n6"};
+
+  auto nodes = Node_Container(nodes_id, nodes_type, types_name, types_count);
+  auto edges = Edge_Container(edges_from, edges_to, nodes_id, nodes);
+  auto blocks = Node_Container(3, nodes, random_engine);
+
+  for (int i = 0; i < 10; i++) {
+    Node* node = nodes.at(0, i % 6);
+    Node* new_block = propose_move(node, blocks, random_engine, 0.5);
+
+    const double pre_move_ent = calc_entropy(blocks);
+    const double move_delta = get_move_results(node, new_block, nodes, blocks, edges, 0.5).entropy_delta;
+
+    swap_block(node, new_block, blocks, false);
+
+    expect_near(calc_entropy(blocks) - pre_move_ent, move_delta);
+  }
+}
+
+
+context("Running multiple chains") {
+  auto nodes_id   = Rcpp::CharacterVector{"a1", "a2", "a3", "a4", "b1", "b2", "b3", "b4"};
+  auto nodes_type = Rcpp::CharacterVector{ "a",  "a",  "a",  "a",  "b",  "b",  "b",  "b"};
+  auto types_name  = Rcpp::CharacterVector{"a", "b"};
+  auto types_count = Rcpp::IntegerVector{    4,   4};
+
+  const Rcpp::CharacterVector edges_from{"a1", "a2", "a2", "a3", "a3", "a3", "a4", "a4"};
+  const Rcpp::CharacterVector   edges_to{"b2", "b1", "b2", "b1", "b2", "b4", "b3", "b4"};
+
+  auto nodes = Node_Container(nodes_id, nodes_type, types_name, types_count);
+  auto edges = Edge_Container(edges_from, edges_to, nodes_id, nodes);
+
+  const auto serial = run_chains(nodes, edges, 2, 10, 4, 42, 0.1, 1);
+  const auto threaded = run_chains(nodes, edges, 2, 10, 4, 42, 0.1, 3);
+
+  test_that("Every chain reports a full trace and assignment") {
+    expect_true(serial.chains.size() == 4);
+    for (const auto& chain : serial.chains) {
+      expect_true(chain.entropy_trace.size() == 11);
+      expect_true(chain.block_assignments.size() == 8);
+    }
+  }
+
+  test_that("Results don't depend on the number of threads") {
+    for (int i = 0; i < 4; i++) {
+      expect_true(serial.chains[i].block_assignments == threaded.chains[i].block_assignments);
+      expect_true(serial.chains[i].entropy_trace == threaded.chains[i].entropy_trace);
+    }
+  }
+
+  test_that("Best chain has the lowest entropy") {
+    for (const auto& chain : serial.chains) {
+      expect_true(serial.chains[serial.best_chain].entropy() <= chain.entropy());
+    }
+  }
+
+  test_that("Original network is left unassigned") {
+    expect_true(nodes.at(0, 0)->get_parent() == nullptr);
+  }
+
+  test_that("Too many blocks is caught before chains start") {
+    expect_error(run_chains(nodes, edges, 5, 10, 4, 42));
+  }
+}
+
+
+context("Beta schedules") {
+  test_that("Constant schedule never changes") {
+    const Beta_Schedule constant;
+    expect_near(constant.beta_at(0, 10), 1.0);
+    expect_near(constant.beta_at(9, 10), 1.0);
+  }
+
+  test_that("Ramps start and end on the requested betas") {
+    const Beta_Schedule linear("linear", 0.1, 1.0);
+    expect_near(linear.beta_at(0, 10), 0.1);
+    expect_near(linear.beta_at(9, 10), 1.0);
+    expect_near(linear.beta_at(3, 4), 1.0);
+    expect_near(linear.beta_at(1, 3), 0.55);
+
+    const Beta_Schedule geometric("geometric", 0.01, 1.0);
+    expect_near(geometric.beta_at(0, 3), 0.01);
+    expect_near(geometric.beta_at(1, 3), 0.1);
+    expect_near(geometric.beta_at(2, 3), 1.0);
+  }
+
+  test_that("Bad schedules are caught") {
+    expect_error(Beta_Schedule("cubic", 0.1, 1.0));
+    expect_error(Beta_Schedule("geometric", 0.0, 1.0));
+  }
+}
+
+
+context("Parallel tempering") {
+  auto nodes_id   = Rcpp::CharacterVector{"a1", "a2", "a3", "a4", "b1", "b2", "b3", "b4"};
+  auto nodes_type = Rcpp::CharacterVector{ "a",  "a",  "a",  "a",  "b",  "b",  "b",  "b"};
+  auto types_name  = Rcpp::CharacterVector{"a", "b"};
+  auto types_count = Rcpp::IntegerVector{    4,   4};
+
+  const Rcpp::CharacterVector edges_from{"a1", "a2", "a2", "a3", "a3", "a3", "a4", "a4"};
+  const Rcpp::CharacterVector   edges_to{"b2", "b1", "b2", "b1", "b2", "b4", "b3", "b4"};
+
+  auto nodes = Node_Container(nodes_id, nodes_type, types_name, types_count);
+  auto edges = Edge_Container(edges_from, edges_to, nodes_id, nodes);
+
+  const Double_Vec betas{1.0, 0.5, 0.25};
+  const auto serial = run_parallel_tempering(nodes, edges, 2, 20, betas, 3, 42, 0.1, 1);
+  const auto threaded = run_parallel_tempering(nodes, edges, 2, 20, betas, 3, 42, 0.1, 3);
+
+  test_that("One trace per temperature with an entry per exchange round") {
+    expect_true(serial.entropy_traces.size() == 3);
+    expect_true(serial.entropy_traces[0].size() == 7);
+    expect_true(serial.block_assignments.size() == 3);
+    expect_true(serial.swap_acceptance.size() == 2);
+  }
+
+  test_that("Swap rates are proportions") {
+    for (const double rate : serial.swap_acceptance) {
+      expect_true(rate >= 0.0 && rate <= 1.0);
+    }
+  }
+
+  test_that("Results don't depend on the number of threads") {
+    for (int i = 0; i < 3; i++) {
+      expect_true(serial.entropy_traces[i] == threaded.entropy_traces[i]);
+      expect_true(serial.block_assignments[i] == threaded.block_assignments[i]);
+    }
+  }
+
+  test_that("Needs a ladder of temperatures") {
+    expect_error(run_parallel_tempering(nodes, edges, 2, 20, Double_Vec{1.0}, 3, 42));
+  }
+}
+
+
+context("Sweep orders all produce valid fits") {
+  auto nodes_id   = Rcpp::CharacterVector{"a1", "a2", "a3", "a4", "b1", "b2", "b3", "b4"};
+  auto nodes_type = Rcpp::CharacterVector{ "a",  "a",  "a",  "a",  "b",  "b",  "b",  "b"};
+  auto types_name  = Rcpp::CharacterVector{"a", "b"};
+  auto types_count = Rcpp::IntegerVector{    4,   4};
+
+  const Rcpp::CharacterVector edges_from{"a1", "a2", "a2", "a3", "a3", "a3", "a4", "a4"};
+  const Rcpp::CharacterVector   edges_to{"b2", "b1", "b2", "b1", "b2", "b4", "b3", "b4"};
+
+  auto nodes = Node_Container(nodes_id, nodes_type, types_name, types_count);
+  auto edges = Edge_Container(edges_from, edges_to, nodes_id, nodes);
+
+  for (const auto order : {Sweep_Order::fixed, Sweep_Order::random, Sweep_Order::degree, Sweep_Order::active}) {
+    SBM sbm(nodes, edges, 2, chain_random_engine(42, 0), order);
+    double entropy = sbm.entropy();
+
+    for (int i = 0; i < 15; i++) {
+      const auto sweep = sbm.mcmc_sweep(0.1);
+      expect_true(sweep.num_nodes_moved <= sweep.num_nodes_visited);
+      expect_true(sweep.num_nodes_visited <= 8);
+      entropy += sweep.entropy_delta;
+    }
+
+    expect_near(entropy, sbm.entropy());
+  }
+}
+
+context("Node types without any edges") {
+  auto nodes_id   = Rcpp::CharacterVector{"a1", "a2", "a3", "b1", "b2", "b3", "c1", "c2"};
+  auto nodes_type = Rcpp::CharacterVector{ "a",  "a",  "a",  "b",  "b",  "b",  "c",  "c"};
+  auto types_name  = Rcpp::CharacterVector{"a", "b", "c"};
+  auto types_count = Rcpp::IntegerVector{    3,   3,   2};
+
+  // Type c has nodes but no edges
+  const Rcpp::CharacterVector edges_from{"a1", "a1", "a2", "a3", "a3"};
+  const Rcpp::CharacterVector   edges_to{"b1", "b2", "b2", "b3", "b1"};
+
+  auto nodes = Node_Container(nodes_id, nodes_type, types_name, types_count);
+  auto edges = Edge_Container(edges_from, edges_to, nodes_id, nodes);
+
+  test_that("Have no neighbor types") {
+    expect_true(edges.neighbor_types_for_node(2).empty());
+    expect_true(edges.neighbor_types_for_node(0) == Int_Vec{1});
+  }
+
+  test_that("Leave the connected types free to be fit") {
+    SBM sbm(nodes, edges, 1, chain_random_engine(42, 0));
+    double entropy = sbm.entropy();
+
+    for (int i = 0; i < 10; i++) {
+      const auto sweep = sbm.mcmc_sweep(0.1);
+      expect_true(sweep.num_nodes_visited == 6);
+      entropy += sweep.entropy_delta;
+    }
+    expect_near(entropy, sbm.entropy());
+
+    SBM two_blocks(nodes, edges, 2, chain_random_engine(42, 0));
+    for (int i = 0; i < 10; i++) two_blocks.mcmc_sweep(0.1);
+    expect_true(std::isfinite(two_blocks.entropy()));
+  }
+
+  test_that("Don't get in the way of choosing a number of blocks") {
+    expect_true(std::isfinite(model_description_length(nodes, edges, 2)));
+    const auto selection = select_num_blocks(nodes, edges, 1, 2, 5, 42, 0.1, 1);
+    expect_true(selection.fits.size() == 2);
+  }
+}
@@ -0,0 +1,48 @@
+#include <testthat.h>
+#include "rcpp_adapter.h"
+#include "SBM_Model.h"
+
+context("Persistent model") {
+  auto nodes_id   = Rcpp::CharacterVector{"a1", "a2", "a3", "a4", "b1", "b2", "b3", "b4"};
+  auto nodes_type = Rcpp::CharacterVector{ "a",  "a",  "a",  "a",  "b",  "b",  "b",  "b"};
+  auto types_name  = Rcpp::CharacterVector{"a", "b"};
+  auto types_count = Rcpp::IntegerVector{    4,   4};
+
+  const Rcpp::CharacterVector edges_from{"a1", "a2", "a2", "a3", "a3", "a3", "a4", "a4"};
+  const Rcpp::CharacterVector   edges_to{"b2", "b1", "b2", "b1", "b2", "b4", "b3", "b4"};
+
+  test_that("Sweeps carry on from where the last call left off") {
+    SBM_Model model(nodes_id, nodes_type, types_name, types_count, edges_from, edges_to, 2);
+    expect_true(model.num_sweeps() == 0);
+
+    const Double_Vec first = model.run_sweeps(4);
+    const Double_Vec second = model.run_sweeps(6);
+
+    expect_true(first.size() == 4);
+    expect_true(second.size() == 6);
+    expect_true(model.num_sweeps() == 10);
+    expect_true(model.get_entropy_trace().size() == 11);
+    expect_true(model.entropy() == second.back());
+    expect_true(model.block_assignments().size() == 8);
+  }
+
+  test_that("Matches the first chain of a multi-chain run with the same seed") {
+    SBM_Model model(nodes_id, nodes_type, types_name, types_count, edges_from, edges_to, 2, 7);
+    model.run_sweeps(3);
+    model.run_sweeps(7);
+
+    auto nodes = Node_Container(nodes_id, nodes_type, types_name, types_count);
+    auto edges = Edge_Container(edges_from, edges_to, nodes_id, nodes);
+    const auto chains = run_chains(nodes, edges, 2, 10, 1, 7);
+
+    expect_true(model.get_entropy_trace() == chains.chains[0].entropy_trace);
+    expect_true(model.block_assignments() == chains.chains[0].block_assignments);
+  }
+
+  test_that("Bad inputs are caught when the model is made") {
+    expect_error(SBM_Model(nodes_id, nodes_type, types_name, types_count, edges_from, edges_to, 5));
+
+    SBM_Model model(nodes_id, nodes_type, types_name, types_count, edges_from, edges_to, 2);
+    expect_error(model.run_sweeps(-1));
+  }
+}
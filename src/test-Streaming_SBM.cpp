@@ -0,0 +1,198 @@
+#include <testthat.h>
+#include "rcpp_adapter.h"
+#include <cstdio>
+#include "Streaming_SBM.h"
+
+// Scores every possible move of every node in a streaming model and in a node based
+// model put in the same blocks, and checks the two agree
+bool scores_match_node_model(const Rcpp::CharacterVector& nodes_id,
+                             const Rcpp::CharacterVector& nodes_type,
+                             const Rcpp::CharacterVector& types_name,
+                             const Rcpp::IntegerVector& types_count,
+                             const Rcpp::CharacterVector& edges_from,
+                             const Rcpp::CharacterVector& edges_to,
+                             const int num_blocks) {
+  const std::string path = "test-adjacency-scores.bin";
+  write_adjacency_file(path, nodes_id, nodes_type, types_name, edges_from, edges_to);
+
+  bool all_match = true;
+  {
+    const Mapped_Adjacency adjacency(path);
+    Streaming_SBM streaming(adjacency, num_blocks, Random_Engine(3));
+    for (int i = 0; i < 5; i++) streaming.mcmc_sweep(0.5, 0.5);
+
+    auto nodes = Node_Container(nodes_id, nodes_type, types_name, types_count);
+    auto edges = Edge_Container(edges_from, edges_to, nodes_id, nodes);
+
+    // Streaming blocks are numbered across types, node based ones within each type
+    Int_Vec positions = streaming.block_assignments();
+    Node_Ptrs node_by_index(nodes.size());
+    for (const auto& nodes_of_type : nodes.nodes) {
+      for (const auto& node : nodes_of_type) {
+        node_by_index[node->index] = node.get();
+        positions[node->index] -= node->type_index * num_blocks;
+      }
+    }
+    auto blocks = Node_Container(num_blocks, nodes, positions);
+
+    const double eps = 0.3;
+    for (int pos = 0; pos < adjacency.num_nodes(); pos++) {
+      if (adjacency.degree(pos) == 0) continue;
+      Node* node = node_by_index[adjacency.node_index(pos)];
+
+      for (int block_i = 0; block_i < num_blocks; block_i++) {
+        Node* new_block = blocks.at(node->type_index, block_i);
+        if (new_block == node->get_parent()) continue;
+
+        const Move_Results streamed =
+            streaming.score_move(pos, node->type_index * num_blocks + block_i, eps);
+        const Move_Results node_based = get_move_results(node, new_block, nodes, blocks, edges, eps);
+
+        all_match = all_match &&
+                    std::abs(streamed.entropy_delta - node_based.entropy_delta) < 1e-10 &&
+                    std::abs(streamed.prob_ratio / node_based.prob_ratio - 1) < 1e-10;
+      }
+    }
+  }
+
+  std::remove(path.c_str());
+  return all_match;
+}
+
+context("Memory-mapped adjacency") {
+  auto nodes_id   = Rcpp::CharacterVector{"b1", "a1", "a2", "b2", "a3", "b3", "a4", "b4"};
+  auto nodes_type = Rcpp::CharacterVector{ "b",  "a",  "a",  "b",  "a",  "b",  "a",  "b"};
+  auto types_name  = Rcpp::CharacterVector{"a", "b"};
+
+  const Rcpp::CharacterVector edges_from{"a1", "a1", "a2", "a2", "a3", "a3", "a4", "a4", "a1"};
+  const Rcpp::CharacterVector   edges_to{"b1", "b2", "b1", "b2", "b3", "b4", "b3", "b4", "b3"};
+
+  const std::string path = "test-adjacency.bin";
+  write_adjacency_file(path, nodes_id, nodes_type, types_name, edges_from, edges_to);
+
+  test_that("File holds nodes grouped by type with their neighbors") {
+    const Mapped_Adjacency adjacency(path);
+
+    expect_true(adjacency.num_nodes() == 8);
+    expect_true(adjacency.num_types() == 2);
+    expect_true(adjacency.num_edge_ends() == 18);
+    expect_true(adjacency.type_edges(0, 1) == 9);
+    expect_true(adjacency.type_edges(0, 0) == 0);
+
+    // a1 comes first, then the rest of the a's, then the b's in input order
+    expect_true(adjacency.node_index(0) == 1);
+    expect_true(adjacency.node_type(0) == 0);
+    expect_true(adjacency.node_index(4) == 0);
+    expect_true(adjacency.node_type(7) == 1);
+
+    // a1 connects to b1, b2 and b3 which sit at positions 4, 5 and 6
+    expect_true(adjacency.degree(0) == 3);
+    const std::int32_t* neighbors = adjacency.neighbors_begin(0);
+    expect_true(neighbors[0] == 4 && neighbors[1] == 5 && neighbors[2] == 6);
+  }
+
+  test_that("Bad inputs and files are caught") {
+    const Rcpp::CharacterVector bad_to{"b1", "b2", "b1", "b2", "b3", "b4", "b3", "b4", "a2"};
+    expect_error(write_adjacency_file("bad.bin", nodes_id, nodes_type, types_name, edges_from, bad_to));
+    expect_error(Mapped_Adjacency("no-such-file.bin"));
+  }
+
+  test_that("Sweeps keep block counts and entropy in step") {
+    const Mapped_Adjacency adjacency(path);
+    Streaming_SBM sbm(adjacency, 2, Random_Engine(42));
+
+    double entropy = sbm.entropy();
+    for (int i = 0; i < 30; i++) entropy += sbm.mcmc_sweep(0.5, 0.3).entropy_delta;
+    expect_true(std::abs(entropy - sbm.entropy()) < 1e-8);
+
+    // Counts rebuilt from the assignments match the ones kept up to date
+    const Int_Vec assignments = sbm.block_assignments();
+    std::vector<int> block_of_pos(adjacency.num_nodes());
+    for (int pos = 0; pos < adjacency.num_nodes(); pos++) {
+      block_of_pos[pos] = assignments[adjacency.node_index(pos)];
+    }
+
+    bool all_match = true;
+    for (int r = 0; r < 4; r++) {
+      std::vector<int> row(4, 0);
+      int degree = 0;
+      for (int pos = 0; pos < adjacency.num_nodes(); pos++) {
+        if (block_of_pos[pos] != r) continue;
+        degree += adjacency.degree(pos);
+        for (const std::int32_t* nbr = adjacency.neighbors_begin(pos); nbr != adjacency.neighbors_end(pos); nbr++) {
+          row[block_of_pos[*nbr]]++;
+        }
+      }
+      all_match = all_match && degree == sbm.get_block_degree(r);
+      for (int s = 0; s < 4; s++) all_match = all_match && row[s] == sbm.get_count(r, s);
+    }
+    expect_true(all_match);
+  }
+
+  std::remove(path.c_str());
+}
+
+
+context("Streaming entropy matches the node based model") {
+  // Unipartite with a self loop
+  auto nodes_id   = Rcpp::CharacterVector{"n1", "n2", "n3", "n4", "n5", "n6"};
+  auto nodes_type = Rcpp::CharacterVector{ "a",  "a",  "a",  "a",  "a",  "a"};
+  auto types_name  = Rcpp::CharacterVector{"a"};
+  auto types_count = Rcpp::IntegerVector{    6};
+
+  const Rcpp::CharacterVector edges_from{"n1", "n1", "n2", "n3", "n3", "n4", "n5", "n5"};
+  const Rcpp::CharacterVector   edges_to{"n2", "n3", "n3", "n4", "n3", "n5", "n6", "n4"};
+
+  const std::string path = "test-adjacency-uni.bin";
+  write_adjacency_file(path, nodes_id, nodes_type, types_name, edges_from, edges_to);
+
+  test_that("Entropy agrees for the same assignments and deltas stay exact") {
+    const Mapped_Adjacency adjacency(path);
+    Streaming_SBM streaming(adjacency, 3, Random_Engine(1));
+
+    double entropy = streaming.entropy();
+    for (int i = 0; i < 40; i++) entropy += streaming.mcmc_sweep(0.5, 0.2).entropy_delta;
+    expect_true(std::abs(entropy - streaming.entropy()) < 1e-8);
+
+    // Put a node based model in the same blocks and compare
+    auto nodes = Node_Container(nodes_id, nodes_type, types_name, types_count);
+    auto edges = Edge_Container(edges_from, edges_to, nodes_id, nodes);
+    auto blocks = Node_Container(3, nodes, streaming.block_assignments());
+    expect_true(std::abs(calc_entropy(blocks) - streaming.entropy()) < 1e-8);
+  }
+
+  std::remove(path.c_str());
+}
+
+
+context("Streaming moves are scored the same as the node based model") {
+  test_that("Unipartite with a self loop") {
+    const Rcpp::CharacterVector nodes_id{"n1", "n2", "n3", "n4", "n5", "n6", "n7"};
+    const Rcpp::CharacterVector nodes_type{"a", "a", "a", "a", "a", "a", "a"};
+    const Rcpp::CharacterVector edges_from{"n1", "n1", "n2", "n3", "n3", "n4", "n5", "n5", "n6", "n7"};
+    const Rcpp::CharacterVector   edges_to{"n2", "n3", "n3", "n4", "n3", "n5", "n6", "n4", "n7", "n1"};
+
+    expect_true(scores_match_node_model(nodes_id, nodes_type, Rcpp::CharacterVector{"a"},
+                                        Rcpp::IntegerVector{7}, edges_from, edges_to, 3));
+  }
+
+  test_that("Bipartite") {
+    const Rcpp::CharacterVector nodes_id{"a1", "a2", "a3", "a4", "b1", "b2", "b3"};
+    const Rcpp::CharacterVector nodes_type{"a", "a", "a", "a", "b", "b", "b"};
+    const Rcpp::CharacterVector edges_from{"a1", "a1", "a2", "a3", "a3", "a4", "a4", "a2"};
+    const Rcpp::CharacterVector   edges_to{"b1", "b2", "b1", "b2", "b3", "b3", "b1", "b3"};
+
+    expect_true(scores_match_node_model(nodes_id, nodes_type, Rcpp::CharacterVector{"a", "b"},
+                                        Rcpp::IntegerVector{4, 3}, edges_from, edges_to, 2));
+  }
+
+  test_that("Three types") {
+    const Rcpp::CharacterVector nodes_id{"a1", "a2", "a3", "b1", "b2", "b3", "c1", "c2", "c3"};
+    const Rcpp::CharacterVector nodes_type{"a", "a", "a", "b", "b", "b", "c", "c", "c"};
+    const Rcpp::CharacterVector edges_from{"a1", "a1", "a2", "a3", "b1", "b2", "b3", "a2", "a3"};
+    const Rcpp::CharacterVector   edges_to{"b1", "b2", "b2", "b3", "c1", "c2", "c3", "c1", "c3"};
+
+    expect_true(scores_match_node_model(nodes_id, nodes_type, Rcpp::CharacterVector{"a", "b", "c"},
+                                        Rcpp::IntegerVector{3, 3, 3}, edges_from, edges_to, 2));
+  }
+}
@@ -0,0 +1,44 @@
+#include <testthat.h>
+#include "rcpp_adapter.h"
+#include "String_Lookup.h"
+
+context("Looking up R strings") {
+  const Rcpp::CharacterVector key_strings{"n1", "n2", "n3", "n2"};
+  const Rcpp::CharacterVector query_strings{"n3", "n2", "n4"};
+  const String_Column keys = key_strings;
+  const String_Column queries = query_strings;
+
+  String_Lookup<int> lookup(keys.size());
+  for (int i = 0; i < keys.size(); i++) lookup.insert(keys[i], i);
+
+  test_that("Strings from other vectors find their values") {
+    expect_true(*lookup.find(queries[0]) == 2);
+    expect_true(lookup.find(queries[2]) == nullptr);
+  }
+
+  test_that("Repeated strings keep their first value") {
+    expect_true(lookup.size() == 3);
+    expect_true(*lookup.find(queries[1]) == 1);
+  }
+
+  test_that("Plain strings fall back to matching on contents") {
+    expect_true(*lookup.find(std::string("n1")) == 0);
+    expect_true(lookup.find(std::string("n5")) == nullptr);
+
+    // Entries added after the fallback map exists are still found
+    const Rcpp::CharacterVector more_keys{"n5"};
+    lookup.insert(String_Column(more_keys)[0], 10);
+    expect_true(*lookup.find(std::string("n5")) == 10);
+  }
+
+  test_that("Pooled strings share addresses like R's strings do") {
+    String_Pool pool;
+    const String_Column ids{pool.intern("a"), pool.intern("b")};
+    String_Lookup<int> pooled_lookup(ids.size());
+    for (int i = 0; i < ids.size(); i++) pooled_lookup.insert(ids[i], i);
+
+    expect_true(pool.intern("b") == ids[1]);
+    expect_true(*pooled_lookup.find_by_address(pool.intern("b")) == 1);
+    expect_true(pooled_lookup.find_by_address(std::string("b").c_str()) == nullptr);
+  }
+}
@@ -0,0 +1,89 @@
+#include <testthat.h>
+#include "rcpp_adapter.h"
+#include "Edge_Container.h"
+#include "Sweep_Scheduler.h"
+#include <random>
+
+context("Sweep scheduling") {
+  Random_Engine random_engine{};
+  random_engine.seed(42);
+
+  // a4 has no edges, a1 has the highest degree
+  auto nodes_id   = Rcpp::CharacterVector{"a1", "a2", "a3", "a4", "b1", "b2", "b3"};
+  auto nodes_type = Rcpp::CharacterVector{ "a",  "a",  "a",  "a",  "b",  "b",  "b"};
+  auto types_name  = Rcpp::CharacterVector{"a", "b"};
+  auto types_count = Rcpp::IntegerVector{    4,   3};
+
+  const Rcpp::CharacterVector edges_from{"a1", "a1", "a1", "a2", "a3"};
+  const Rcpp::CharacterVector   edges_to{"b1", "b2", "b3", "b2", "b3"};
+
+  auto nodes = Node_Container(nodes_id, nodes_type, types_name, types_count);
+  auto edges = Edge_Container(edges_from, edges_to, nodes_id, nodes);
+  auto node_by_id = nodes.get_id_to_node_map(nodes_id);
+
+  test_that("Fixed order follows the container and skips unconnected nodes") {
+    Sweep_Scheduler scheduler(nodes, Sweep_Order::fixed);
+    const Node_Ptrs visits = scheduler.next_sweep(random_engine);
+
+    expect_true(visits.size() == 6);
+    expect_true(visits[0] == nodes.at(0, 0));
+    expect_true(std::find(visits.begin(), visits.end(), node_by_id.at("a4")) == visits.end());
+    expect_true(scheduler.next_sweep(random_engine) == visits);
+  }
+
+  test_that("Random order visits every node once in a new order") {
+    Sweep_Scheduler scheduler(nodes, Sweep_Order::random);
+    Node_Ptrs first = scheduler.next_sweep(random_engine);
+    Node_Ptrs second = scheduler.next_sweep(random_engine);
+
+    expect_true(first.size() == 6);
+    std::sort(first.begin(), first.end());
+    std::sort(second.begin(), second.end());
+    expect_true(first == second);
+  }
+
+  test_that("Degree order starts with highest degree nodes") {
+    Sweep_Scheduler scheduler(nodes, Sweep_Order::degree);
+    const Node_Ptrs& visits = scheduler.next_sweep(random_engine);
+
+    expect_true(visits[0] == node_by_id.at("a1"));
+    for (int i = 1; i < visits.size(); i++) {
+      expect_true(visits[i - 1]->get_degree() >= visits[i]->get_degree());
+    }
+  }
+
+  test_that("Active order only revisits changed neighborhoods") {
+    Sweep_Scheduler scheduler(nodes, Sweep_Order::active, 5);
+
+    // First sweep always covers everything
+    expect_true(scheduler.next_sweep(random_engine).size() == 6);
+
+    // a2 moving makes it and its only neighbor b2 active
+    scheduler.node_moved(node_by_id.at("a2"));
+    Node_Ptrs visits = scheduler.next_sweep(random_engine);
+    std::sort(visits.begin(), visits.end());
+    Node_Ptrs expected{node_by_id.at("a2"), node_by_id.at("b2")};
+    std::sort(expected.begin(), expected.end());
+    expect_true(visits == expected);
+
+    // Nothing moved, so nothing is visited until the next full sweep
+    expect_true(scheduler.next_sweep(random_engine).empty());
+    expect_true(scheduler.next_sweep(random_engine).empty());
+    expect_true(scheduler.next_sweep(random_engine).empty());
+    expect_true(scheduler.next_sweep(random_engine).size() == 6);
+  }
+
+  test_that("Active order does a full sweep every interval") {
+    Sweep_Scheduler scheduler(nodes, Sweep_Order::active, 2);
+    scheduler.next_sweep(random_engine);
+    scheduler.node_moved(node_by_id.at("a3"));
+    expect_true(scheduler.next_sweep(random_engine).size() == 2);
+    scheduler.node_moved(node_by_id.at("a3"));
+    expect_true(scheduler.next_sweep(random_engine).size() == 6);
+  }
+
+  test_that("Sweep orders can be chosen by name") {
+    expect_true(sweep_order_from_name("active") == Sweep_Order::active);
+    expect_error(sweep_order_from_name("backwards"));
+  }
+}
@@ -1,4 +1,5 @@
 #include <testthat.h>
+#include "rcpp_adapter.h"
 #include "Node_Container.h"
 #include <random>
 
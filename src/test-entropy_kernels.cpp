@@ -0,0 +1,82 @@
+#include <testthat.h>
+#include "entropy_kernels.h"
+#include <random>
+
+// Relative agreement, as vector kernels sum in a different order than the scalar one
+bool close_to(const double a, const double b, const double rel_thresh = 1e-12) {
+  return std::abs(a - b) <= rel_thresh * std::max(1.0, std::abs(b));
+}
+
+Entropy_Terms random_terms(const int size, std::mt19937& random_engine) {
+  std::uniform_int_distribution<> count_dist(1, 5000);
+  std::uniform_int_distribution<> degree_dist(1, 1000000);
+  std::bernoulli_distribution is_self;
+  std::bernoulli_distribution is_post;
+
+  Entropy_Terms terms;
+  for (int i = 0; i < size; i++) {
+    const double weight = (is_post(random_engine) ? -1.0 : 1.0) * (is_self(random_engine) ? 0.5 : 1.0);
+    terms.add(count_dist(random_engine), degree_dist(random_engine), degree_dist(random_engine), weight);
+  }
+  return terms;
+}
+
+double scalar_sum(const Entropy_Terms& terms) {
+  return sum_entropy_terms_scalar(terms.n_edges.data(), terms.degree_product.data(),
+                                  terms.weight.data(), terms.size());
+}
+
+context("Entropy term kernels") {
+  std::mt19937 random_engine(42);
+
+  test_that("Empty pairs are never stored") {
+    Entropy_Terms terms;
+    terms.add(0, 3, 4, 1);
+    terms.add(2, 3, 4, 1);
+    expect_true(terms.size() == 1);
+    expect_true(terms.degree_product[0] == 12);
+  }
+
+  test_that("Scalar kernel matches direct calculation") {
+    Entropy_Terms terms;
+    terms.add(4, 8, 9, 1);
+    terms.add(2, 7, 7, 0.5);
+    terms.add(3, 7, 9, -1);
+
+    const double expected = 4 * std::log(4.0 / 72) + 0.5 * 2 * std::log(2.0 / 49) - 3 * std::log(3.0 / 63);
+    expect_true(close_to(scalar_sum(terms), expected));
+    expect_true(close_to(sum_entropy_terms(terms), expected));
+  }
+
+  test_that("Dispatched kernel agrees with scalar kernel for all tail lengths") {
+    for (int size = 0; size < 40; size++) {
+      const auto terms = random_terms(size, random_engine);
+      expect_true(close_to(sum_entropy_terms(terms), scalar_sum(terms)));
+    }
+
+    const auto big_terms = random_terms(5000, random_engine);
+    expect_true(close_to(sum_entropy_terms(big_terms), scalar_sum(big_terms)));
+  }
+
+#ifdef SBM_X86_KERNELS
+  test_that("Each vector kernel the CPU supports agrees with the scalar kernel") {
+    const auto terms = random_terms(1001, random_engine);
+    const double expected = scalar_sum(terms);
+    const double* n = terms.n_edges.data();
+    const double* dd = terms.degree_product.data();
+    const double* w = terms.weight.data();
+
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+      expect_true(close_to(sum_entropy_terms_avx2(n, dd, w, terms.size()), expected));
+    }
+    if (__builtin_cpu_supports("avx512f")) {
+      expect_true(close_to(sum_entropy_terms_avx512(n, dd, w, terms.size()), expected));
+    }
+  }
+#endif
+
+  test_that("A kernel is always available") {
+    const std::string name = entropy_kernel_name();
+    expect_true(name == "scalar" || name == "avx2" || name == "avx512");
+  }
+}
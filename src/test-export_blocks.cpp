@@ -0,0 +1,92 @@
+#include <testthat.h>
+#include "rcpp_adapter.h"
+#include "SBM.h"
+
+// Exported counts agree with the ones a block works out from its children, and with
+// each other
+bool exports_match_blocks(Node_Container& blocks) {
+  const int span = block_index_span(blocks);
+  Int_Vec matrix(span * span, 0);
+  write_block_edge_matrix(blocks, span, matrix.begin());
+
+  const int num_entries = num_block_edge_entries(blocks);
+  Int_Vec rows(num_entries);
+  Int_Vec cols(num_entries);
+  Int_Vec counts(num_entries);
+  write_block_edge_triplets(blocks, rows.begin(), cols.begin(), counts.begin(), 1);
+
+  Int_Vec from_triplets(span * span, 0);
+  for (int entry_i = 0; entry_i < num_entries; entry_i++) {
+    if (counts[entry_i] == 0) return false;
+    from_triplets[(rows[entry_i] - 1) + (cols[entry_i] - 1) * span] = counts[entry_i];
+  }
+  if (from_triplets != matrix) return false;
+
+  int num_nonzero = 0;
+  for (const auto& blocks_of_type : blocks.nodes) {
+    for (const auto& block : blocks_of_type) {
+      for (const auto& entry : block->get_block_edge_counts()) {
+        if (matrix[block->index + entry.first->index * span] != entry.second) return false;
+        num_nonzero++;
+      }
+    }
+  }
+  return num_nonzero == num_entries;
+}
+
+context("Exporting blocks in bulk") {
+  auto nodes_id   = Rcpp::CharacterVector{"a1", "a2", "a3", "a4", "a5", "b1", "b2", "b3"};
+  auto nodes_type = Rcpp::CharacterVector{ "a",  "a",  "a",  "a",  "a",  "b",  "b",  "b"};
+  auto types_name  = Rcpp::CharacterVector{"a", "b"};
+  auto types_count = Rcpp::IntegerVector{    5,   3};
+
+  const Rcpp::CharacterVector edges_from{"a1", "a1", "a2", "a3", "a3", "a4", "a5", "a5"};
+  const Rcpp::CharacterVector   edges_to{"b1", "b2", "b1", "b2", "b3", "b3", "b1", "b3"};
+
+  auto nodes = Node_Container(nodes_id, nodes_type, types_name, types_count);
+  auto edges = Edge_Container(edges_from, edges_to, nodes_id, nodes);
+
+  test_that("Assignments come out in node order") {
+    SBM sbm(nodes, edges, 2, Random_Engine(5));
+    Int_Vec assignments(nodes.size(), -1);
+    write_block_assignments(sbm.get_nodes(), assignments.begin());
+    expect_true(assignments == sbm.block_assignments());
+
+    for (const auto& nodes_of_type : sbm.get_nodes().nodes) {
+      for (const auto& node : nodes_of_type) {
+        expect_true(assignments[node->index] == node->get_parent()->index);
+      }
+    }
+  }
+
+  test_that("Edge counts match the blocks, dense or sparse") {
+    SBM sbm(nodes, edges, 2, Random_Engine(5));
+    expect_true(block_index_span(sbm.get_blocks()) == 4);
+    expect_true(exports_match_blocks(sbm.get_blocks()));
+
+    sbm.get_blocks().get_edge_counts().set_max_dense_bytes(0);
+    expect_true(exports_match_blocks(sbm.get_blocks()));
+
+    for (int i = 0; i < 5; i++) sbm.mcmc_sweep(0.5, 1.0);
+    expect_true(exports_match_blocks(sbm.get_blocks()));
+  }
+
+  test_that("Block stats add up to the network") {
+    SBM sbm(nodes, edges, 2, Random_Engine(5));
+    Node_Container& blocks = sbm.get_blocks();
+    const int num_blocks = blocks.size();
+
+    Int_Vec indices(num_blocks);
+    Int_Vec types(num_blocks);
+    Int_Vec sizes(num_blocks);
+    Int_Vec degrees(num_blocks);
+    write_block_stats(blocks, indices.begin(), types.begin(), sizes.begin(), degrees.begin());
+
+    expect_true(indices == Int_Vec({0, 1, 2, 3}));
+    expect_true(types == Int_Vec({0, 0, 1, 1}));
+    expect_true(sizes[0] + sizes[1] == 5);
+    expect_true(sizes[2] + sizes[3] == 3);
+    expect_true(degrees[0] + degrees[1] == 8);
+    expect_true(degrees[2] + degrees[3] == 8);
+  }
+}
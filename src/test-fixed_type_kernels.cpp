@@ -0,0 +1,123 @@
+#include <testthat.h>
+#include "rcpp_adapter.h"
+#include "SBM.h"
+
+// Kernels with the number of types fixed at compile time make the same draws and give
+// the same answers as the general versions
+template <int N_Types>
+bool kernels_match_general(Node_Container& nodes, Node_Container& blocks) {
+  for (int type_i = 0; type_i < nodes.num_types(); type_i++) {
+    for (const auto& node : nodes.get_nodes_of_type(type_i)) {
+      Random_Engine fixed_engine(11);
+      Random_Engine general_engine(11);
+      for (int i = 0; i < 20; i++) {
+        if (node->get_random_neighbor<N_Types>(fixed_engine) !=
+            node->get_random_neighbor<0>(general_engine)) {
+          return false;
+        }
+      }
+
+      Block_Histogram fixed;
+      Block_Histogram general;
+      fixed.fill<N_Types>(node.get());
+      general.fill<0>(node.get());
+      if (fixed.counts != general.counts || fixed.self_edges != general.self_edges) return false;
+
+      if (propose_move<N_Types>(node.get(), blocks, fixed_engine, 0.3) !=
+          propose_move<0>(node.get(), blocks, general_engine, 0.3)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+context("Unipartite kernels") {
+  auto nodes_id   = Rcpp::CharacterVector{"n1", "n2", "n3", "n4", "n5", "n6"};
+  auto nodes_type = Rcpp::CharacterVector{ "a",  "a",  "a",  "a",  "a",  "a"};
+  auto types_name  = Rcpp::CharacterVector{"a"};
+  auto types_count = Rcpp::IntegerVector{    6};
+
+  const Rcpp::CharacterVector edges_from{"n1", "n1", "n2", "n3", "n4", "n4", "n5", "n6"};
+  const Rcpp::CharacterVector   edges_to{"n2", "n3", "n3", "n4", "n4", "n5", "n6", "n4"};
+
+  auto nodes = Node_Container(nodes_id, nodes_type, types_name, types_count);
+  auto edges = Edge_Container(edges_from, edges_to, nodes_id, nodes);
+
+  test_that("Match the general kernels") {
+    Random_Engine random_engine(42);
+    auto blocks = Node_Container(2, nodes, random_engine);
+    expect_true(kernels_match_general<1>(nodes, blocks));
+  }
+}
+
+context("Bipartite kernels") {
+  auto nodes_id   = Rcpp::CharacterVector{"a1", "a2", "a3", "a4", "b1", "b2", "b3"};
+  auto nodes_type = Rcpp::CharacterVector{ "a",  "a",  "a",  "a",  "b",  "b",  "b"};
+  auto types_name  = Rcpp::CharacterVector{"a", "b"};
+  auto types_count = Rcpp::IntegerVector{    4,   3};
+
+  const Rcpp::CharacterVector edges_from{"a1", "a1", "a2", "a3", "b3", "a4", "a4"};
+  const Rcpp::CharacterVector   edges_to{"b1", "b2", "b1", "b2", "a3", "b3", "b1"};
+
+  auto nodes = Node_Container(nodes_id, nodes_type, types_name, types_count);
+  auto edges = Edge_Container(edges_from, edges_to, nodes_id, nodes);
+
+  test_that("Match the general kernels") {
+    Random_Engine random_engine(42);
+    auto blocks = Node_Container(2, nodes, random_engine);
+    expect_true(kernels_match_general<2>(nodes, blocks));
+  }
+
+  test_that("Edge types come out the same as when checked edge by edge") {
+    expect_true(edges.neighbor_types_for_node(0) == Int_Vec{1});
+    expect_true(edges.neighbor_types_for_node(1) == Int_Vec{0});
+
+    const Rcpp::CharacterVector same_type_from{"a1", "a1"};
+    const Rcpp::CharacterVector   same_type_to{"b1", "a2"};
+    auto fresh_nodes = Node_Container(nodes_id, nodes_type, types_name, types_count);
+    expect_error(Edge_Container(same_type_from, same_type_to, nodes_id, fresh_nodes));
+  }
+
+  test_that("Swapping with the bipartite kernel keeps degrees and counts right") {
+    Random_Engine random_engine(3);
+    auto blocks = Node_Container(2, nodes, random_engine);
+    Node* a1 = nodes.at(0, 0);
+    Node* new_block = a1->get_parent() == blocks.at(0, 0) ? blocks.at(0, 1) : blocks.at(0, 0);
+    const unsigned b1_version = nodes.at(1, 0)->get_neighborhood_version();
+
+    swap_block<2>(a1, new_block, blocks, false);
+
+    expect_true(a1->get_parent() == new_block);
+    expect_true(nodes.at(1, 0)->get_neighborhood_version() == b1_version + 1);
+    int degree_of_children = 0;
+    for (const Node* child : new_block->children) degree_of_children += child->get_degree();
+    expect_true(new_block->get_degree() == degree_of_children);
+    expect_true(new_block->get_block_edge_counts().size() > 0);
+  }
+}
+
+context("Networks with more than two types keep the general kernels") {
+  auto nodes_id   = Rcpp::CharacterVector{"a1", "a2", "a3", "b1", "b2", "b3", "c1", "c2"};
+  auto nodes_type = Rcpp::CharacterVector{ "a",  "a",  "a",  "b",  "b",  "b",  "c",  "c"};
+  auto types_name  = Rcpp::CharacterVector{"a", "b", "c"};
+  auto types_count = Rcpp::IntegerVector{    3,   3,   2};
+
+  const Rcpp::CharacterVector edges_from{"a1", "a2", "a3", "a3", "b1", "b2", "b3", "a1"};
+  const Rcpp::CharacterVector   edges_to{"b1", "b2", "b2", "b3", "c1", "c2", "c1", "c2"};
+
+  auto nodes = Node_Container(nodes_id, nodes_type, types_name, types_count);
+  auto edges = Edge_Container(edges_from, edges_to, nodes_id, nodes);
+
+  test_that("Entropy tracks the sweeps") {
+    SBM sbm(nodes, edges, 2, Random_Engine(9));
+    double entropy = sbm.entropy();
+    bool all_match = true;
+
+    for (int i = 0; i < 20; i++) {
+      entropy += sbm.mcmc_sweep(0.5, 1.0).entropy_delta;
+      all_match = all_match && std::abs(entropy - sbm.entropy()) < 1e-8;
+    }
+    expect_true(all_match);
+  }
+}
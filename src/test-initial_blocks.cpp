@@ -0,0 +1,101 @@
+#include <testthat.h>
+#include "rcpp_adapter.h"
+#include "run_chains.h"
+#include <random>
+
+// Every block has at least one child and every child sits in a block of its type
+bool blocks_are_valid(const Node_Container& blocks, const Node_Container& nodes, const int num_blocks) {
+  for (int type_i = 0; type_i < blocks.num_types(); type_i++) {
+    const auto& blocks_of_type = blocks.nodes[type_i];
+    if (blocks_of_type.size() != num_blocks) return false;
+    for (const auto& block : blocks_of_type) {
+      if (block->num_children() == 0) return false;
+    }
+    for (const auto& node : nodes.nodes[type_i]) {
+      if (node->get_parent() == nullptr || node->get_parent()->type_index != type_i) return false;
+    }
+  }
+  return true;
+}
+
+context("Label propagation starting blocks") {
+  Random_Engine random_engine{};
+  random_engine.seed(42);
+
+  // Two cliques of four joined by a single edge, plus an unconnected node
+  auto nodes_id   = Rcpp::CharacterVector{"n1", "n2", "n3", "n4", "n5", "n6", "n7", "n8", "n9"};
+  auto nodes_type = Rcpp::CharacterVector{ "a",  "a",  "a",  "a",  "a",  "a",  "a",  "a",  "a"};
+  auto types_name  = Rcpp::CharacterVector{"a"};
+  auto types_count = Rcpp::IntegerVector{    9};
+
+  const Rcpp::CharacterVector edges_from{"n1", "n1", "n1", "n2", "n2", "n3", "n5", "n5", "n5", "n6", "n6", "n7", "n4"};
+  const Rcpp::CharacterVector   edges_to{"n2", "n3", "n4", "n3", "n4", "n4", "n6", "n7", "n8", "n7", "n8", "n8", "n5"};
+
+  auto nodes = Node_Container(nodes_id, nodes_type, types_name, types_count);
+  auto edges = Edge_Container(edges_from, edges_to, nodes_id, nodes);
+  auto node_by_id = nodes.get_id_to_node_map(nodes_id);
+
+  test_that("Cliques end up in their own blocks") {
+    auto blocks = initial_blocks(3, nodes, random_engine, Block_Init::label_propagation);
+
+    expect_true(blocks_are_valid(blocks, nodes, 3));
+    expect_true(node_by_id.at("n1")->get_parent() == node_by_id.at("n3")->get_parent());
+    expect_true(node_by_id.at("n6")->get_parent() == node_by_id.at("n8")->get_parent());
+    expect_true(node_by_id.at("n1")->get_parent() != node_by_id.at("n8")->get_parent());
+  }
+
+  test_that("Block edge counts are filled in") {
+    auto blocks = initial_blocks(2, nodes, random_engine, Block_Init::label_propagation);
+    Node* block_1 = node_by_id.at("n1")->get_parent();
+
+    expect_true(blocks.get_edge_counts().get(block_1, block_1) ==
+                block_1->get_block_edge_counts().at(block_1));
+  }
+
+  test_that("Thread count doesn't change the result") {
+    Random_Engine engine_a(7);
+    Random_Engine engine_b(7);
+    const Group_Keys serial = label_propagation_keys(nodes, engine_a, 1);
+    const Group_Keys threaded = label_propagation_keys(nodes, engine_b, 4);
+    expect_true(serial == threaded);
+  }
+}
+
+
+context("Signature starting blocks") {
+  Random_Engine random_engine{};
+  random_engine.seed(42);
+
+  // a1 and a2 share all their neighbors, as do a3 and a4
+  auto nodes_id   = Rcpp::CharacterVector{"a1", "a2", "a3", "a4", "b1", "b2", "b3", "b4"};
+  auto nodes_type = Rcpp::CharacterVector{ "a",  "a",  "a",  "a",  "b",  "b",  "b",  "b"};
+  auto types_name  = Rcpp::CharacterVector{"a", "b"};
+  auto types_count = Rcpp::IntegerVector{    4,   4};
+
+  const Rcpp::CharacterVector edges_from{"a1", "a1", "a2", "a2", "a3", "a3", "a4", "a4"};
+  const Rcpp::CharacterVector   edges_to{"b1", "b2", "b1", "b2", "b3", "b4", "b3", "b4"};
+
+  auto nodes = Node_Container(nodes_id, nodes_type, types_name, types_count);
+  auto edges = Edge_Container(edges_from, edges_to, nodes_id, nodes);
+  auto node_by_id = nodes.get_id_to_node_map(nodes_id);
+
+  test_that("Nodes with the same neighbors share a block") {
+    auto blocks = initial_blocks(2, nodes, random_engine, Block_Init::signature);
+
+    expect_true(blocks_are_valid(blocks, nodes, 2));
+    expect_true(node_by_id.at("a1")->get_parent() == node_by_id.at("a2")->get_parent());
+    expect_true(node_by_id.at("a3")->get_parent() == node_by_id.at("a4")->get_parent());
+  }
+
+  test_that("More blocks than groups still fills every block") {
+    auto blocks = initial_blocks(4, nodes, random_engine, Block_Init::signature);
+    expect_true(blocks_are_valid(blocks, nodes, 4));
+  }
+
+  test_that("Chains can start from informed blocks") {
+    const auto results = run_chains(nodes, edges, 2, 5, 2, 42, 0.1, 1, Beta_Schedule(),
+                                    Sweep_Order::fixed, Block_Init::label_propagation);
+    expect_true(results.chains[0].entropy_trace.size() == 6);
+    expect_error(initial_blocks(5, nodes, random_engine, Block_Init::signature));
+  }
+}
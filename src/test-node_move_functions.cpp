@@ -1,7 +1,9 @@
 #include <testthat.h>
+#include "rcpp_adapter.h"
 #include "Edge_Container.h"
 #include "propose_move.h"
 #include "get_move_results.h"
+#include "calc_entropy.h"
 #include "swap_blocks.h"
 #include <random>
 
@@ -76,21 +78,24 @@ context("Edge counts are properly accounted after swapping") {
   Node * ba2 = a2->get_parent();
 
   // Blocks should just mimic their only node's edge counts
-  expect_true(ba1->get_edges_to_type(1).size() == 2);
-  expect_true(ba1->get_edges_to_type(2).size() == 1);
+  expect_true(ba1->get_degree_to_type(1) == 2);
+  expect_true(ba1->get_degree_to_type(2) == 1);
 
-  expect_true(ba2->get_edges_to_type(1).size() == 2);
-  expect_true(ba2->get_edges_to_type(2).size() == 2);
+  expect_true(ba2->get_degree_to_type(1) == 2);
+  expect_true(ba2->get_degree_to_type(2) == 2);
 
   // Now we want to bring a2 into the same group as a1 (don't remove empty group)
   swap_block(a2, ba1, blocks, false);
 
   // Blocks should just mimic their only node's edge counts
-  expect_true(ba1->get_edges_to_type(1).size() == 4);
-  expect_true(ba1->get_edges_to_type(2).size() == 3);
+  expect_true(ba1->get_degree_to_type(1) == 4);
+  expect_true(ba1->get_degree_to_type(2) == 3);
 
-  expect_true(ba2->get_edges_to_type(1).size() == 0);
-  expect_true(ba2->get_edges_to_type(2).size() == 0);
+  expect_true(ba2->get_degree_to_type(1) == 0);
+  expect_true(ba2->get_degree_to_type(2) == 0);
+
+  // Blocks hold no edge lists of their own
+  expect_true(total_num_elements(ba1->get_edges()) == 0);
 
 }
 
@@ -323,3 +328,167 @@ context("Move proposal returns values are correct (simple bipartite)") {
 }
 
 
+
+
+context("Batch move results match single moves and full recalculation") {
+  Random_Engine random_engine{};
+  random_engine.seed(42);
+
+  auto nodes_id   = Rcpp::CharacterVector{"n1", "n2", "n3", "n4", "n5", "n6", "n7", "n8"};
+  auto nodes_type = Rcpp::CharacterVector{ "a",  "a",  "a",  "a",  "a",  "a",  "a",  "a"};
+  auto types_name  = Rcpp::CharacterVector{"a"};
+  auto types_count = Rcpp::IntegerVector{    8};
+
+  // Includes self edges (n1, n6) and a repeated edge (n3 - n4)
+  const Rcpp::CharacterVector edges_from{"n1", "n1", "n1", "n2", "n2", "n3", "n3", "n3", "n4", "n5", "n6", "n6", "n7", "n8"};
+  const Rcpp::CharacterVector   edges_to{"n1", "n2", "n5", "n3", "n6", "n4", "n4", "n7", "n8", "n6", "n6", "n8", "n8", "n1"};
+
+  auto nodes = Node_Container(nodes_id, nodes_type, types_name, types_count);
+  auto edges = Edge_Container(edges_from, edges_to, nodes_id, nodes);
+  auto blocks = Node_Container(4, nodes, random_engine);
+
+  // Every block of the type as a candidate
+  Node_Ptrs candidates;
+  for (const auto& block : blocks.get_nodes_of_type(0)) candidates.push_back(block.get());
+
+  const double eps = 0.3;
+  const double epsB = eps * candidates.size();
+
+  for (int i = 0; i < 8; i++) {
+    Node* node = nodes.at(0, i);
+    Node* old_block = node->get_parent();
+    const auto batch_results = get_move_results(node, candidates, nodes, blocks, edges, eps);
+
+    expect_true(batch_results.size() == candidates.size());
+
+    for (int j = 0; j < candidates.size(); j++) {
+      Node* new_block = candidates[j];
+      const auto single_result = get_move_results(node, new_block, nodes, blocks, edges, eps);
+
+      expect_approx_equal(batch_results[j].entropy_delta, single_result.entropy_delta, 1e-10);
+      expect_approx_equal(batch_results[j].prob_ratio, single_result.prob_ratio, 1e-10);
+
+      // Reference values from actually making the move
+      const auto node_to_blocks = node->get_block_edge_counts();
+      const double pre_ent = calc_entropy(blocks);
+      const double prob_to_new = calc_move_prob(node_to_blocks, new_block, node->get_degree(), eps, epsB);
+
+      swap_block(node, new_block, blocks, false);
+      const double post_ent = calc_entropy(blocks);
+      const double prob_back = calc_move_prob(node_to_blocks, old_block, node->get_degree(), eps, epsB);
+      swap_block(node, old_block, blocks, false);
+
+      expect_approx_equal(batch_results[j].entropy_delta, post_ent - pre_ent, 1e-10);
+      expect_approx_equal(batch_results[j].prob_ratio, prob_back / prob_to_new, 1e-10);
+    }
+
+    // Shuffle the partition around between nodes
+    swap_block(node, candidates[i % candidates.size()], blocks, false);
+  }
+}
+
+
+context("Cached degrees stay in sync with edges") {
+  Random_Engine random_engine{};
+  random_engine.seed(42);
+
+  auto nodes_id   = Rcpp::CharacterVector{"a1", "a2", "a3", "b1", "b2", "b3", "c1", "c2"};
+  auto nodes_type = Rcpp::CharacterVector{ "a",  "a",  "a",  "b",  "b",  "b",  "c",  "c"};
+  auto types_name  = Rcpp::CharacterVector{"a", "b", "c"};
+  auto types_count = Rcpp::IntegerVector{    3,   3,   2};
+
+  const Rcpp::CharacterVector edges_from{"a1", "a1", "a2", "a3", "a3", "b1", "b2", "b3"};
+  const Rcpp::CharacterVector   edges_to{"b1", "c1", "b2", "b2", "b3", "c2", "c1", "c2"};
+
+  auto nodes = Node_Container(nodes_id, nodes_type, types_name, types_count);
+  auto edges = Edge_Container(edges_from, edges_to, nodes_id, nodes);
+  auto blocks = Node_Container(2, nodes, random_engine);
+
+  auto expect_degrees_match_edges = [](Node_Container& container) {
+    for (const auto& nodes_of_type : container.nodes) {
+      for (const auto& node : nodes_of_type) {
+        expect_true(node->get_degree() == total_num_elements(node->get_edges()));
+        for (int type_i = 0; type_i < 3; type_i++) {
+          expect_true(node->get_degree_to_type(type_i) == node->get_edges_to_type(type_i).size());
+        }
+      }
+    }
+  };
+
+  // A block's degrees are the sum of its children's
+  auto expect_degrees_match_children = [](Node_Container& container) {
+    for (const auto& blocks_of_type : container.nodes) {
+      for (const auto& block : blocks_of_type) {
+        int degree = 0;
+        std::vector<int> degrees_to_type(3, 0);
+        for (const Node* child : block->children) {
+          degree += child->get_degree();
+          for (int type_i = 0; type_i < 3; type_i++) {
+            degrees_to_type[type_i] += child->get_edges_to_type(type_i).size();
+          }
+        }
+
+        expect_true(block->get_degree() == degree);
+        for (int type_i = 0; type_i < 3; type_i++) {
+          expect_true(block->get_degree_to_type(type_i) == degrees_to_type[type_i]);
+        }
+      }
+    }
+  };
+
+  test_that("Nodes and freshly built blocks have right degrees") {
+    expect_true(nodes.get_id_to_node_map(nodes_id).at("a3")->get_degree() == 2);
+    expect_true(nodes.get_id_to_node_map(nodes_id).at("c2")->get_degree_to_type(1) == 2);
+    expect_degrees_match_edges(nodes);
+    expect_degrees_match_children(blocks);
+  }
+
+  test_that("Block degrees follow nodes as they move") {
+    for (int i = 0; i < 20; i++) {
+      Node* node = nodes.at(i % 3, i % 2);
+      swap_block(node, propose_move(node, blocks, random_engine), blocks, false);
+      expect_degrees_match_children(blocks);
+    }
+  }
+}
+
+
+context("Move contexts hold per-type proposal constants") {
+  Random_Engine random_engine{};
+  random_engine.seed(42);
+
+  auto nodes_id   = Rcpp::CharacterVector{"a1", "a2", "b1", "b2", "b3", "c1", "c2", "c3"};
+  auto nodes_type = Rcpp::CharacterVector{ "a",  "a",  "b",  "b",  "b",  "c",  "c",  "c"};
+  auto types_name  = Rcpp::CharacterVector{"a", "b", "c"};
+  auto types_count = Rcpp::IntegerVector{    2,   3,   3};
+
+  // Only a-b and a-c connections
+  const Rcpp::CharacterVector edges_from{"a1", "a1", "a1", "a2", "a2", "a2", "a2"};
+  const Rcpp::CharacterVector   edges_to{"b1", "b2", "c1", "b2", "b3", "c2", "c3"};
+
+  auto nodes = Node_Container(nodes_id, nodes_type, types_name, types_count);
+  auto edges = Edge_Container(edges_from, edges_to, nodes_id, nodes);
+  auto blocks = Node_Container(2, nodes, random_engine);
+
+  const auto contexts = build_move_contexts(blocks, edges, 0.5);
+
+  test_that("One context per type with counts of blocks") {
+    expect_true(contexts.size() == 3);
+    expect_true(contexts[0].n_potential_blocks == 2);
+    expect_true(contexts[0].n_possible_neighbors == 4); // Blocks of b and c
+    expect_true(contexts[1].n_possible_neighbors == 2); // Blocks of a
+    expect_approx_equal(contexts[0].epsB, 2.0, 1e-12);
+    expect_approx_equal(contexts[1].ergo_amnt, 1.0, 1e-12);
+  }
+
+  test_that("Scoring with a context matches scoring from scratch") {
+    Node* a1 = nodes.get_id_to_node_map(nodes_id).at("a1");
+    Node* other_block = blocks.at(0, 0) == a1->get_parent() ? blocks.at(0, 1) : blocks.at(0, 0);
+
+    const auto from_scratch = get_move_results(a1, other_block, nodes, blocks, edges, 0.5);
+    const auto from_context = Move_Evaluator(a1, contexts[0]).evaluate(other_block);
+
+    expect_approx_equal(from_scratch.entropy_delta, from_context.entropy_delta, 1e-12);
+    expect_approx_equal(from_scratch.prob_ratio, from_context.prob_ratio, 1e-12);
+  }
+}
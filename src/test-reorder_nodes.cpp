@@ -0,0 +1,120 @@
+#include <testthat.h>
+#include "rcpp_adapter.h"
+#include "Edge_Container.h"
+#include "reorder_nodes.h"
+#include <random>
+
+// Largest distance in container position between two connected nodes
+int bandwidth(Node_Container& nodes) {
+  std::vector<int> position(nodes.size());
+  for (int i = 0; i < nodes.size_of_type(0); i++) position[nodes.at(0, i)->index] = i;
+
+  int widest = 0;
+  for (const auto& node : nodes.get_nodes_of_type(0)) {
+    for (const auto& neighbor : node->get_edges_to_type(0)) {
+      widest = std::max(widest, std::abs(position[node->index] - position[neighbor->index]));
+    }
+  }
+  return widest;
+}
+
+context("Reordering nodes for locality") {
+  // A path n0 - n1 - ... - n9, with the nodes provided in scrambled order
+  const Rcpp::CharacterVector nodes_id{"n7", "n2", "n9", "n0", "n5", "n3", "n8", "n1", "n6", "n4"};
+  const Rcpp::CharacterVector nodes_type{"a", "a", "a", "a", "a", "a", "a", "a", "a", "a"};
+  const Rcpp::CharacterVector types_name{"a"};
+  const Rcpp::IntegerVector types_count{10};
+
+  const Rcpp::CharacterVector edges_from{"n0", "n1", "n2", "n3", "n4", "n5", "n6", "n7", "n8"};
+  const Rcpp::CharacterVector   edges_to{"n1", "n2", "n3", "n4", "n5", "n6", "n7", "n8", "n9"};
+
+  test_that("Leaving input order changes nothing") {
+    auto nodes = Node_Container(nodes_id, nodes_type, types_name, types_count);
+    auto edges = Edge_Container(edges_from, edges_to, nodes_id, nodes);
+    Node* first = nodes.at(0, 0);
+    reorder_nodes(nodes, Node_Order::input);
+    expect_true(nodes.at(0, 0) == first);
+  }
+
+  test_that("Reverse Cuthill-McKee lays a path out end to end") {
+    auto nodes = Node_Container(nodes_id, nodes_type, types_name, types_count);
+    auto edges = Edge_Container(edges_from, edges_to, nodes_id, nodes);
+    expect_true(bandwidth(nodes) > 1);
+
+    reorder_nodes(nodes, Node_Order::rcm);
+    expect_true(bandwidth(nodes) == 1);
+    expect_true(nodes.size() == 10);
+
+    // Ids are untouched so results can still be reported against input
+    const auto node_by_id = nodes.get_id_to_node_map(nodes_id);
+    expect_true(node_by_id.at("n0")->get_degree() == 1);
+    expect_true(node_by_id.at("n4")->get_degree() == 2);
+  }
+
+  test_that("Breadth first order keeps neighbors close") {
+    auto nodes = Node_Container(nodes_id, nodes_type, types_name, types_count);
+    auto edges = Edge_Container(edges_from, edges_to, nodes_id, nodes);
+    reorder_nodes(nodes, Node_Order::bfs);
+
+    // Starts from first node given, n7, and fans out in both directions
+    expect_true(nodes.at(0, 0) == nodes.get_id_to_node_map(nodes_id).at("n7"));
+    expect_true(bandwidth(nodes) <= 2);
+  }
+
+  test_that("Degree order puts ends of the path last") {
+    auto nodes = Node_Container(nodes_id, nodes_type, types_name, types_count);
+    auto edges = Edge_Container(edges_from, edges_to, nodes_id, nodes);
+    reorder_nodes(nodes, Node_Order::degree);
+
+    expect_true(nodes.at(0, 7)->get_degree() == 2);
+    expect_true(nodes.at(0, 8)->get_degree() == 1);
+    expect_true(nodes.at(0, 9)->get_degree() == 1);
+  }
+
+  test_that("Neighbor lists follow new order") {
+    auto nodes = Node_Container(nodes_id, nodes_type, types_name, types_count);
+    auto edges = Edge_Container(edges_from, edges_to, nodes_id, nodes);
+    reorder_nodes(nodes, Node_Order::rcm);
+
+    Node* middle = nodes.at(0, 5);
+    const Node_Ptrs& neighbors = middle->get_edges_to_type(0);
+    expect_true(neighbors.size() == 2);
+    expect_true(neighbors[0] == nodes.at(0, 4));
+    expect_true(neighbors[1] == nodes.at(0, 6));
+  }
+
+  test_that("Clones are laid out in the new order") {
+    auto nodes = Node_Container(nodes_id, nodes_type, types_name, types_count);
+    auto edges = Edge_Container(edges_from, edges_to, nodes_id, nodes);
+    reorder_nodes(nodes, Node_Order::rcm);
+    auto copy = nodes.clone();
+
+    for (int i = 0; i < 10; i++) expect_true(copy.at(0, i)->index == nodes.at(0, i)->index);
+    expect_true(bandwidth(copy) == 1);
+  }
+
+  test_that("Unknown orders are caught") {
+    expect_error(node_order_from_name("random"));
+  }
+}
+
+
+context("Reordering keeps nodes grouped by type") {
+  auto nodes = Node_Container(Rcpp::CharacterVector{"a1", "a2", "b1", "b2"},
+                              Rcpp::CharacterVector{ "a",  "a",  "b",  "b"},
+                              Rcpp::CharacterVector{"a", "b"},
+                              Rcpp::IntegerVector{    2,   2});
+  auto nodes_id = Rcpp::CharacterVector{"a1", "a2", "b1", "b2"};
+  auto edges = Edge_Container(Rcpp::CharacterVector{"a1", "a2"},
+                              Rcpp::CharacterVector{"b2", "b1"},
+                              nodes_id, nodes);
+
+  reorder_nodes(nodes, Node_Order::rcm);
+
+  expect_true(nodes.size_of_type(0) == 2);
+  expect_true(nodes.size_of_type(1) == 2);
+  for (int i = 0; i < 2; i++) {
+    expect_true(nodes.at(0, i)->type_index == 0);
+    expect_true(nodes.at(1, i)->type_index == 1);
+  }
+}
@@ -0,0 +1,118 @@
+#include <testthat.h>
+#include "rcpp_adapter.h"
+#include <set>
+#include "select_num_blocks.h"
+
+context("Selecting the number of blocks") {
+  // Three cliques of six nodes, joined in a ring by single edges
+  std::vector<std::string> id_strings;
+  for (const char group : {'a', 'b', 'c'}) {
+    for (int i = 1; i <= 6; i++) id_strings.push_back(std::string(1, group) + std::to_string(i));
+  }
+  String_Pool pool;
+  String_Column nodes_id;
+  String_Column nodes_type;
+  for (const auto& id : id_strings) {
+    nodes_id.push_back(pool.intern(id));
+    nodes_type.push_back(pool.intern("node"));
+  }
+  const String_Column types_name{pool.intern("node")};
+  const std::vector<int> types_count{18};
+
+  String_Column edges_from;
+  String_Column edges_to;
+  for (int group = 0; group < 3; group++) {
+    for (int i = 0; i < 6; i++) {
+      for (int j = i + 1; j < 6; j++) {
+        edges_from.push_back(nodes_id[group * 6 + i]);
+        edges_to.push_back(nodes_id[group * 6 + j]);
+      }
+    }
+    edges_from.push_back(nodes_id[group * 6]);
+    edges_to.push_back(nodes_id[((group + 1) % 3) * 6 + 1]);
+  }
+
+  auto nodes = Node_Container(nodes_id, nodes_type, types_name, types_count);
+  auto edges = Edge_Container(edges_from, edges_to, nodes_id, nodes);
+
+  // Whether every clique sits in a block of its own
+  auto finds_cliques = [](const Int_Vec& positions) {
+    for (int node_i = 0; node_i < 18; node_i++) {
+      for (int other_i = 0; other_i < 18; other_i++) {
+        const bool same_clique = node_i / 6 == other_i / 6;
+        if (same_clique != (positions[node_i] == positions[other_i])) return false;
+      }
+    }
+    return true;
+  };
+
+  test_that("Model description length grows with the number of blocks") {
+    double last_length = model_description_length(nodes, edges, 1);
+    expect_true(std::abs(last_length - 48 * (x_log_x(1 + 1.0 / 48) - x_log_x(1.0 / 48))) < 1e-10);
+
+    for (int num_blocks = 2; num_blocks <= 10; num_blocks++) {
+      const double length = model_description_length(nodes, edges, num_blocks);
+      expect_true(length > last_length);
+      last_length = length;
+    }
+  }
+
+  test_that("Merging halves of cliques puts the cliques back together") {
+    Int_Vec halves(18);
+    for (int node_i = 0; node_i < 18; node_i++) halves[node_i] = node_i / 3;
+
+    const Int_Vec merged = merge_blocks(nodes, edges, halves, 6, 3);
+    expect_true(finds_cliques(merged));
+    expect_true(*std::max_element(merged.begin(), merged.end()) == 2);
+  }
+
+  test_that("Splitting fills every new block") {
+    const Int_Vec one_block(18, 0);
+    const Int_Vec split = split_blocks(nodes, one_block, 1, 5);
+
+    Int_Vec block_sizes(5, 0);
+    for (const int position : split) block_sizes[position]++;
+    for (const int size : block_sizes) expect_true(size > 0);
+  }
+
+  test_that("Warm starts leave a partition alone when the count doesn't change") {
+    Int_Vec positions(18);
+    for (int node_i = 0; node_i < 18; node_i++) positions[node_i] = node_i % 4;
+    expect_true(warm_start_positions(nodes, edges, positions, 4, 4) == positions);
+  }
+
+  test_that("Search finds the planted number of blocks") {
+    const auto selection = select_num_blocks(nodes, edges, 1, 8, 40, 42, 0.1, 1, 3);
+    const Block_Count_Fit& best = selection.fits[selection.best_fit];
+
+    expect_true(best.num_blocks == 3);
+    expect_true(finds_cliques(best.block_positions));
+
+    // Every value is fitted at most once and later rounds are all warm started
+    std::set<int> seen;
+    for (const auto& fit : selection.fits) {
+      expect_true(seen.insert(fit.num_blocks).second);
+      expect_true((fit.round == 0) == (fit.warm_start_from == 0));
+      expect_true(fit.num_blocks >= 1 && fit.num_blocks <= 8);
+    }
+    expect_true(selection.fits.size() < 8);
+  }
+
+  test_that("Results don't depend on the number of threads") {
+    const auto serial = select_num_blocks(nodes, edges, 2, 7, 10, 7, 0.1, 1);
+    const auto threaded = select_num_blocks(nodes, edges, 2, 7, 10, 7, 0.1, 3);
+
+    expect_true(serial.fits.size() == threaded.fits.size());
+    for (int fit_i = 0; fit_i < serial.fits.size(); fit_i++) {
+      expect_true(serial.fits[fit_i].num_blocks == threaded.fits[fit_i].num_blocks);
+      expect_true(serial.fits[fit_i].description_length == threaded.fits[fit_i].description_length);
+    }
+  }
+
+  test_that("Bad ranges are caught") {
+    expect_error(select_num_blocks(nodes, edges, 0, 4, 10, 42));
+    expect_error(select_num_blocks(nodes, edges, 5, 4, 10, 42));
+    expect_error(select_num_blocks(nodes, edges, 1, 19, 10, 42));
+    expect_error(select_num_blocks(nodes, edges, 1, 4, 10, 42, 0.1, 1, 1));
+  }
+}
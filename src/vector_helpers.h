@@ -1,10 +1,12 @@
 #ifndef __VECTOR_HELPERS_INCLUDED__
 #define __VECTOR_HELPERS_INCLUDED__
 
-#include <Rcpp.h>
+#include <algorithm>
+#include <memory>
 #include <utility>
 #include <vector>
 #include <random>
+#include "error_helpers.h"
 
 
 template <typename T>
@@ -70,7 +72,7 @@ template <typename T>
 T& get_random_element(Vec_of_Vecs<T>& vec_of_vecs, std::mt19937& random_generator) {
   // Make a random uniform to index into vectors
   const int n = total_num_elements(vec_of_vecs);
-  if (n == 0) Rcpp::stop("Can't take a random sample of empty vectors");
+  if (n == 0) stop("Can't take a random sample of empty vectors");
 
   std::uniform_int_distribution<> runif {0, n - 1};
 
@@ -86,7 +88,7 @@ T& get_random_element(Vec_of_Vecs<T>& vec_of_vecs, std::mt19937& random_generato
       return sub_vec[random_index];
     }
   }
-  Rcpp::stop("Random element could not be selected. Check formation of vectors");
+  stop("Random element could not be selected. Check formation of vectors");
   // Default return is just the first element... potentially dangerous
   return vec_of_vecs.at(0).at(0);
 }
@@ -100,4 +102,13 @@ T& get_random_element(std::vector<T>& vec, std::mt19937& random_generator) {
   return vec[runif(random_generator)];
 }
 
+template <typename T>
+const T& get_random_element(const std::vector<T>& vec, std::mt19937& random_generator) {
+
+  // Make a random uniform to index into vectors
+  std::uniform_int_distribution<> runif {0, int(vec.size() - 1)};
+
+  return vec[runif(random_generator)];
+}
+
 #endif